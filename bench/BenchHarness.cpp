@@ -0,0 +1,89 @@
+#include "BenchHarness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+double BenchResult::percentile(double p) const
+{
+    if(runNs.empty())
+        return 0;
+    // nearest rank
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * runNs.size()));
+    return runNs[std::clamp<size_t>(rank, 1, runNs.size()) - 1];
+}
+
+double BenchResult::mean() const
+{
+    if(runNs.empty())
+        return 0;
+    return std::accumulate(runNs.begin(), runNs.end(), 0.0) / runNs.size();
+}
+
+void BenchHarness::add(std::string name, std::string unit, std::function<uint64_t()> run)
+{
+    entries.push_back(Entry{std::move(name), std::move(unit), std::move(run)});
+}
+
+void BenchHarness::runAll(std::ostream& log)
+{
+    using Clock = std::chrono::steady_clock;
+
+    for(auto& entry : entries)
+    {
+        if(!config.filter.empty() && entry.name.find(config.filter) == std::string::npos)
+            continue;
+
+        log << entry.name << " ..." << std::flush;
+        for(size_t i = 0; i != config.warmup; i++)
+            entry.run();
+
+        BenchResult result {.name = entry.name, .unit = entry.unit};
+        for(size_t i = 0; i != config.repetitions; i++)
+        {
+            const auto start = Clock::now();
+            result.itemsPerRun = entry.run();
+            result.runNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        }
+        std::sort(result.runNs.begin(), result.runNs.end());
+        log << " done\n";
+
+        results.push_back(std::move(result));
+    }
+}
+
+void BenchHarness::printTable(std::ostream& os) const
+{
+    os << std::left << std::setw(32) << "benchmark" << std::right
+       << std::setw(12) << "p50 ms" << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "min ms"
+       << std::setw(16) << "items/s" << "  unit\n";
+
+    os << std::fixed;
+    for(auto& it : results)
+    {
+        os << std::left << std::setw(32) << it.name << std::right << std::setprecision(3)
+           << std::setw(12) << it.percentile(50) / 1e6 << std::setw(12) << it.percentile(90) / 1e6
+           << std::setw(12) << it.percentile(99) / 1e6 << std::setw(12) << it.runNs.front() / 1e6
+           << std::setprecision(0) << std::setw(16) << it.itemsPerSecond() << "  " << it.unit << "\n";
+    }
+    os << std::defaultfloat;
+}
+
+void BenchHarness::printJson(std::ostream& os) const
+{
+    // names and units are plain identifiers, nothing to escape
+    os << std::setprecision(12);
+    os << "{\n  \"warmup\": " << config.warmup << ",\n  \"repetitions\": " << config.repetitions << ",\n  \"benchmarks\": [";
+    for(size_t i = 0; i != results.size(); i++)
+    {
+        auto& it = results[i];
+        os << (i == 0 ? "\n" : ",\n")
+           << "    {\"name\": \"" << it.name << "\", \"unit\": \"" << it.unit << "\", \"items_per_run\": " << it.itemsPerRun
+           << ", \"ns\": {\"min\": " << it.runNs.front() << ", \"p50\": " << it.percentile(50) << ", \"p90\": " << it.percentile(90)
+           << ", \"p99\": " << it.percentile(99) << ", \"max\": " << it.runNs.back() << ", \"mean\": " << it.mean()
+           << "}, \"items_per_second\": " << it.itemsPerSecond() << "}";
+    }
+    os << "\n  ]\n}\n" << std::setprecision(6);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchConfig
+{
+    size_t warmup {3};          // untimed runs before measuring, fill caches and quicken the interpreter
+    size_t repetitions {20};    // timed runs
+    std::string filter {};      // substring of benchmark name, empty runs all
+};
+
+struct BenchResult
+{
+    std::string name {};
+    std::string unit {};            // what run counted, e.g. "tokens"
+    uint64_t itemsPerRun {};
+    std::vector<double> runNs {};   // duration of every timed run, sorted
+
+    double percentile(double p) const;
+    double mean() const;
+    double itemsPerSecond() const { return itemsPerRun / (percentile(50) / 1e9); } // at median run
+};
+
+// Runs registered benchmarks one after another: warmup, then repetitions timed one run each.
+// Every run returns number of items it processed, which gives throughput next to the duration percentiles.
+class BenchHarness
+{
+public:
+    explicit BenchHarness(BenchConfig inConfig) : config(std::move(inConfig)) {};
+
+    void add(std::string name, std::string unit, std::function<uint64_t()> run);
+
+    // progress goes to log, results are kept for the reports below
+    void runAll(std::ostream& log);
+
+    void printTable(std::ostream& os) const;
+    void printJson(std::ostream& os) const;
+
+protected:
+    struct Entry
+    {
+        std::string name;
+        std::string unit;
+        std::function<uint64_t()> run;
+    };
+
+    BenchConfig config;
+    std::vector<Entry> entries {};
+    std::vector<BenchResult> results {};
+};
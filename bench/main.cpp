@@ -0,0 +1,331 @@
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BenchHarness.hpp"
+
+#include "AstParser.hpp"
+#include "AstResolver.hpp"
+#include "AstTreeWalkInterpreter.hpp"
+#include "ByteCodeCompiler.hpp"
+#include "ByteCodeVm.hpp"
+#include "CodeSource.hpp"
+#include "LexScanner.hpp"
+#include "LexTokenBuffer.hpp"
+#include "OutputSink.hpp"
+#include "QLang.hpp"
+#include "ScriptRunner.hpp"
+
+namespace
+{
+    const char* USAGE =
+        "usage: qlang_bench [--warmup=<n>] [--reps=<n>] [--filter=<substring>] [--json[=<path>]]\n"
+        "  --json          print results as json on stdout instead of the table\n"
+        "  --json=<path>   print the table and write json to path\n";
+
+    // discards printed values, benchmarks measure the interpreter and not the terminal
+    class CountingOutputSink final : public OutputSink
+    {
+    public:
+        void write(std::string_view text) override { bytes += text.size(); }
+
+        size_t bytes {};
+    };
+
+    struct Script
+    {
+        const char* name;
+        const char* unit;
+        uint64_t items;     // counted by one run, for throughput
+        const char* code;
+    };
+
+    // kernels of treeWallInterpret and ByteCodeVm, every one is a single loop so items are easy to count
+    const std::vector<Script> SCRIPTS = {
+        {"arithmetic", "ops", 20000 * 8, R"(
+            i := 0 s := 0
+            while i < 20000 { s := s + i * 3 - i / 2 + i % 7 i := i + 1 }
+        )"},
+        {"loops", "iterations", 200 * 500, R"(
+            i := 0
+            while i < 200 { j := 0 while j < 500 { j := j + 1 } i := i + 1 }
+        )"},
+        {"strings", "concatenations", 10000 * 3, R"(
+            i := 0 s := ""
+            while i < 10000 { s := "item" + i + ", " + true i := i + 1 }
+        )"},
+        {"calls", "calls", 20000, R"(
+            inc := fn(a) { ret a + 1 }
+            i := 0
+            while i < 20000 { i := inc(i) }
+        )"},
+        {"recursion", "calls", 21891, R"(
+            fib := fn(n) { if n < 2 { ret n } ret fib(n-1) + fib(n-2) }
+            r := fib(20)
+        )"},
+        {"arrays", "elements", 10 * 4 * 100000, R"(
+            a := range(0, 100000) b := fill(100000, 0.5)
+            i := 0 s := 0.0
+            while i < 10 { c := a * b + a s := s + sum(c) + dot(a, b) i := i + 1 }
+        )"},
+        {"pfor", "iterations", 200 * 500, R"(
+            s := pfor(i := 0, 200, +) { j := 0 while j < 500 { j := j + 1 } j }
+        )"},
+    };
+
+    // end to end run through runSource: lex, parse, optimize, resolve and execute
+    const char* MACRO_SCRIPT = R"(
+        fib := fn(n) { if n < 2 { ret n } ret fib(n-1) + fib(n-2) }
+        gcd := fn(a, b) { while b != 0 { t := b b := a % b a := t } ret a }
+        total := 0
+        for (i := 1, i < 300, i := i + 1) { total := total + gcd(i * 7, 91) }
+        label := ""
+        for (i := 0, i < 200, i := i + 1) { if i % 2 == 0 { label := "even " + i } else { label := "odd " + i } }
+        x := 0.5
+        for (i := 0, i < 500, i := i + 1) { x := x * 1.5 - x / 3.0 + 0.25 }
+        print fib(15) print " " print total print " " print label print " " print x print "\n"
+    )";
+
+    // short rule evaluated once per input through the embedding api, measures per-run overhead of Context
+    const char* RULE_SCRIPT = R"(
+        discount := 0.0
+        if count > 10 { discount := 0.1 }
+        if member { discount := discount + 0.05 }
+        ret price * count * (1.0 - discount)
+    )";
+
+    std::string repeat(std::string_view text, size_t times)
+    {
+        std::string result;
+        result.reserve(text.size() * times);
+        for(size_t i = 0; i != times; i++)
+            result += text;
+        return result;
+    }
+
+    RuntimeBudget unlimitedBudget()
+    {
+        return RuntimeBudget{.fuel = std::numeric_limits<uint64_t>::max()};
+    }
+
+    // script parsed and resolved once, run repeatedly on a fresh global scope
+    struct PreparedScript
+    {
+        explicit PreparedScript(const Script& script)
+            : source(std::make_shared<CodeSource>(script.name, script.code)), scanner(source, SEPARATORS), tokens(scanner)
+        {
+            root = AstParser(tokens, arena).block();
+            resolver.resolve(root);
+            chunk = ByteCodeCompiler().compile(root);
+        }
+
+        void runTree()
+        {
+            RuntimeScope global(nullptr, resolver.globalCount());
+            RuntimeContext context(global, output, unlimitedBudget());
+            treeWallInterpret(root, context, global, true);
+        }
+
+        void runVm()
+        {
+            RuntimeScope global(nullptr, resolver.globalCount());
+            RuntimeContext context(global, output, unlimitedBudget());
+            ByteCodeVm(context).run(chunk);
+        }
+
+        std::shared_ptr<CodeSource> source;
+        LexScanner scanner;
+        LexTokenBuffer tokens;
+        AstNode::Arena arena {};
+        AstNode::NodePtr root {};
+        AstResolver resolver {};
+        ByteCode::Chunk chunk {};
+        CountingOutputSink output {};
+    };
+
+    void addLexerAndParser(BenchHarness& harness)
+    {
+        std::string text;
+        for(auto& it : SCRIPTS)
+            text += it.code;
+        text += MACRO_SCRIPT;
+        auto source = std::make_shared<CodeSource>("lexer", repeat(text, 200));
+
+        harness.add("lex", "tokens", [source]()
+        {
+            LexScanner scanner(source, SEPARATORS);
+            LexTokenBuffer tokens(scanner);
+            CodeSourceRegistry::release(scanner.getSourceId());
+            return static_cast<uint64_t>(tokens.size());
+        });
+
+        // concatenated scripts are still one valid program
+        auto scanner = std::make_shared<LexScanner>(source, SEPARATORS);
+        auto tokens = std::make_shared<LexTokenBuffer>(*scanner);
+        harness.add("parse", "nodes", [scanner, tokens]()
+        {
+            tokens->restart();
+            AstNode::Arena arena;
+            AstParser(*tokens, arena).block();
+            return static_cast<uint64_t>(arena.nodeCount());
+        });
+    }
+
+    void addInterpreters(BenchHarness& harness)
+    {
+        for(auto& script : SCRIPTS)
+        {
+            auto prepared = std::make_shared<PreparedScript>(script);
+            harness.add(std::string("tree/") + script.name, script.unit, [prepared, items = script.items]()
+            {
+                prepared->runTree();
+                return items;
+            });
+            harness.add(std::string("vm/") + script.name, script.unit, [prepared, items = script.items]()
+            {
+                prepared->runVm();
+                return items;
+            });
+        }
+    }
+
+    void addEndToEnd(BenchHarness& harness)
+    {
+        auto source = std::make_shared<CodeSource>("macro", MACRO_SCRIPT);
+        for(bool useVm : {false, true})
+        {
+            harness.add(useVm ? "e2e/vm" : "e2e/tree", "scripts", [source, useVm]()
+            {
+                RuntimeScope global(nullptr);
+                AstResolver resolver;
+                CountingOutputSink output;
+                RunOptions options {.useVm = useVm, .fuel = std::numeric_limits<uint64_t>::max()};
+                if(!runSource(source, global, resolver, output, options))
+                    throw std::runtime_error("benchmark script failed");
+                return uint64_t{1};
+            });
+        }
+    }
+
+    constexpr uint64_t RULE_RUNS = 1000;
+
+    void runRule(QLang::Context& context)
+    {
+        for(uint64_t i = 0; i != RULE_RUNS; i++)
+        {
+            context.set("price", TemporaryValue::Float{1.5f});
+            context.set("count", TemporaryValue::Integer{static_cast<int>(i % 20)});
+            context.set("member", TemporaryValue::Bool{i % 3 == 0});
+            if(!context.run().ok())
+                throw std::runtime_error("benchmark rule failed");
+        }
+    }
+
+    void addEmbedding(BenchHarness& harness)
+    {
+        for(auto backend : {QLang::Backend::TreeWalk, QLang::Backend::Vm})
+        {
+            auto program = QLang::Program::compile("rule", RULE_SCRIPT, {.backend = backend});
+            auto context = std::make_shared<QLang::Context>(program);
+            harness.add(backend == QLang::Backend::Vm ? "embed/vm" : "embed/tree", "runs", [context]()
+            {
+                runRule(*context);
+                return RULE_RUNS;
+            });
+        }
+
+        // one context per hardware thread, sharing the program or each running its own isolate
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        auto program = QLang::Program::compile("rule", RULE_SCRIPT);
+        for(bool isolated : {false, true})
+        {
+            auto contexts = std::make_shared<std::vector<std::unique_ptr<QLang::Context>>>();
+            for(size_t i = 0; i != threads; i++)
+                contexts->push_back(isolated ? std::make_unique<QLang::Isolate>(*program) : std::make_unique<QLang::Context>(program));
+
+            harness.add(isolated ? "threads/isolates" : "threads/shared", "runs", [contexts]()
+            {
+                std::vector<std::jthread> workers;
+                for(auto& it : *contexts)
+                    workers.emplace_back([&context = *it]() { runRule(context); });
+                workers.clear();
+                return RULE_RUNS * contexts->size();
+            });
+        }
+    }
+
+    bool parseCount(std::string_view in, size_t& out)
+    {
+        const auto [end, error] = std::from_chars(in.data(), in.data() + in.size(), out);
+        return error == std::errc() && end == in.data() + in.size();
+    }
+}
+
+// qlang_bench - throughput of lexer, parser, both interpreters, whole runs and embedded runs, see USAGE
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    bool jsonOnly = false;
+    std::string jsonPath;
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        bool valid = true;
+        if(arg.starts_with("--warmup="))
+            valid = parseCount(arg.substr(9), config.warmup);
+        else if(arg.starts_with("--reps="))
+            valid = parseCount(arg.substr(7), config.repetitions) && config.repetitions != 0;
+        else if(arg.starts_with("--filter="))
+            config.filter = arg.substr(9);
+        else if(arg == "--json")
+            jsonOnly = true;
+        else if(arg.starts_with("--json="))
+            jsonPath = arg.substr(7);
+        else
+            valid = false;
+
+        if(!valid)
+        {
+            std::cerr << "invalid argument: " << arg << "\n" << USAGE;
+            return 2;
+        }
+    }
+
+#ifndef __OPTIMIZE__
+    std::cerr << "warning: benchmarks built without optimizations\n";
+#endif
+
+    BenchHarness harness(config);
+    addLexerAndParser(harness);
+    addInterpreters(harness);
+    addEndToEnd(harness);
+    addEmbedding(harness);
+
+    harness.runAll(std::cerr);
+
+    if(jsonOnly)
+    {
+        harness.printJson(std::cout);
+        return 0;
+    }
+
+    harness.printTable(std::cout);
+    if(!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath);
+        if(!file)
+        {
+            std::cerr << "couldn't write " << jsonPath << "\n";
+            return 1;
+        }
+        harness.printJson(file);
+    }
+    return 0;
+}
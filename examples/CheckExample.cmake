@@ -0,0 +1,17 @@
+# Runs one example script for ctest, see qlang_example in CMakeLists.txt.
+# Fails when the exit code is not EXIT_CODE or printed output differs from EXPECTED; diagnostics on stderr are not compared.
+separate_arguments(options UNIX_COMMAND "${OPTIONS}")
+execute_process(
+        COMMAND ${QLANG} ${options} ${SCRIPT}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+        RESULT_VARIABLE code
+)
+file(READ ${EXPECTED} expected)
+
+if(NOT code STREQUAL EXIT_CODE)
+    message(FATAL_ERROR "exit code ${code}, expected ${EXIT_CODE}\n${errors}")
+endif()
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "output differs from ${EXPECTED}:\n${output}\n${errors}")
+endif()
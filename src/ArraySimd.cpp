@@ -0,0 +1,399 @@
+#include "ArraySimd.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define QLANG_ARRAY_X86 1
+#endif
+
+namespace
+{
+    using ArraySimd::Op;
+
+    constexpr size_t LANES = 8;
+
+    // operand read element by element
+    struct Elements
+    {
+        const float* values;
+        float at(size_t i) const { return values[i]; }
+    };
+
+    // operand repeating one value
+    struct Repeated
+    {
+        float value;
+        float at(size_t) const { return value; }
+    };
+
+    template<Op TOp>
+    float scalarOp(float l, float r)
+    {
+        if constexpr (TOp == Op::Add)               return l + r;
+        else if constexpr (TOp == Op::Subtract)     return l - r;
+        else if constexpr (TOp == Op::Multiply)     return l * r;
+        else if constexpr (TOp == Op::Divide)       return l / r;
+        else if constexpr (TOp == Op::Equal)        return l == r ? 1.0f : 0.0f;
+        else if constexpr (TOp == Op::NotEqual)     return l != r ? 1.0f : 0.0f;
+        else if constexpr (TOp == Op::Less)         return l < r ? 1.0f : 0.0f;
+        else if constexpr (TOp == Op::Greater)      return l > r ? 1.0f : 0.0f;
+        else if constexpr (TOp == Op::LessEqual)    return l <= r ? 1.0f : 0.0f;
+        else                                        return l >= r ? 1.0f : 0.0f;
+    }
+
+    template<Op TOp, typename TLeft, typename TRight>
+    void applyScalar(TLeft left, TRight right, float* out, size_t from, size_t size)
+    {
+        for(; from != size; from++)
+            out[from] = scalarOp<TOp>(left.at(from), right.at(from));
+    }
+
+    // reductions other than dot, folding values into an accumulator
+    enum class Fold { Add, Min, Max };
+
+    // same operand order as minps and maxps, which return the second operand when either is NaN
+    template<Fold TFold>
+    float foldScalar(float acc, float v)
+    {
+        if constexpr (TFold == Fold::Add)           return acc + v;
+        else if constexpr (TFold == Fold::Min)      return acc < v ? acc : v;
+        else                                        return acc > v ? acc : v;
+    }
+
+    // lanes hold 8 interleaved partial results, values from 'from' on are folded in one by one after them
+    template<Fold TFold>
+    float finish(const float* lanes, const float* in, size_t from, size_t size)
+    {
+        constexpr auto fold = foldScalar<TFold>;
+        const float low = fold(fold(lanes[0], lanes[1]), fold(lanes[2], lanes[3]));
+        const float high = fold(fold(lanes[4], lanes[5]), fold(lanes[6], lanes[7]));
+        float acc = fold(low, high);
+        for(; from != size; from++)
+            acc = fold(acc, in[from]);
+        return acc;
+    }
+
+    float finishDot(const float* lanes, const float* left, const float* right, size_t from, size_t size)
+    {
+        float acc = finish<Fold::Add>(lanes, nullptr, 0, 0);
+        for(; from != size; from++)
+            acc += left[from] * right[from];
+        return acc;
+    }
+
+    // ranges shorter than LANES are folded one by one on every isa
+    template<Fold TFold>
+    float reduceShort(const float* in, size_t size)
+    {
+        float acc = in[0];
+        for(size_t i = 1; i != size; i++)
+            acc = foldScalar<TFold>(acc, in[i]);
+        return acc;
+    }
+
+    float dotShort(const float* left, const float* right, size_t size)
+    {
+        float acc = left[0] * right[0];
+        for(size_t i = 1; i != size; i++)
+            acc += left[i] * right[i];
+        return acc;
+    }
+
+    struct Scalar
+    {
+        template<Op TOp, typename TLeft, typename TRight>
+        static void apply(TLeft left, TRight right, float* out, size_t size)
+        {
+            applyScalar<TOp>(left, right, out, 0, size);
+        }
+
+        template<Fold TFold>
+        static float reduce(const float* in, size_t size)
+        {
+            if(size < LANES)
+                return reduceShort<TFold>(in, size);
+
+            float lanes[LANES];
+            for(size_t k = 0; k != LANES; k++)
+                lanes[k] = in[k];
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+            {
+                for(size_t k = 0; k != LANES; k++)
+                    lanes[k] = foldScalar<TFold>(lanes[k], in[i+k]);
+            }
+            return finish<TFold>(lanes, in, i, size);
+        }
+
+        static float dot(const float* left, const float* right, size_t size)
+        {
+            if(size < LANES)
+                return dotShort(left, right, size);
+
+            float lanes[LANES];
+            for(size_t k = 0; k != LANES; k++)
+                lanes[k] = left[k] * right[k];
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+            {
+                for(size_t k = 0; k != LANES; k++)
+                    lanes[k] += left[i+k] * right[i+k];
+            }
+            return finishDot(lanes, left, right, i, size);
+        }
+    };
+
+#ifdef QLANG_ARRAY_X86
+    __m128 loadSse2(Elements in, size_t i) { return _mm_loadu_ps(in.values + i); }
+    __m128 loadSse2(Repeated in, size_t) { return _mm_set1_ps(in.value); }
+
+    template<Op TOp>
+    __m128 opSse2(__m128 l, __m128 r)
+    {
+        const auto one = _mm_set1_ps(1.0f);
+        if constexpr (TOp == Op::Add)               return _mm_add_ps(l, r);
+        else if constexpr (TOp == Op::Subtract)     return _mm_sub_ps(l, r);
+        else if constexpr (TOp == Op::Multiply)     return _mm_mul_ps(l, r);
+        else if constexpr (TOp == Op::Divide)       return _mm_div_ps(l, r);
+        else if constexpr (TOp == Op::Equal)        return _mm_and_ps(_mm_cmpeq_ps(l, r), one);
+        else if constexpr (TOp == Op::NotEqual)     return _mm_and_ps(_mm_cmpneq_ps(l, r), one);
+        else if constexpr (TOp == Op::Less)         return _mm_and_ps(_mm_cmplt_ps(l, r), one);
+        else if constexpr (TOp == Op::Greater)      return _mm_and_ps(_mm_cmpgt_ps(l, r), one);
+        else if constexpr (TOp == Op::LessEqual)    return _mm_and_ps(_mm_cmple_ps(l, r), one);
+        else                                        return _mm_and_ps(_mm_cmpge_ps(l, r), one);
+    }
+
+    template<Fold TFold>
+    __m128 foldSse2(__m128 acc, __m128 v)
+    {
+        if constexpr (TFold == Fold::Add)           return _mm_add_ps(acc, v);
+        else if constexpr (TFold == Fold::Min)      return _mm_min_ps(acc, v);
+        else                                        return _mm_max_ps(acc, v);
+    }
+
+    // lanes 0-3 and 4-7 in two registers
+    struct Sse2
+    {
+        template<Op TOp, typename TLeft, typename TRight>
+        static void apply(TLeft left, TRight right, float* out, size_t size)
+        {
+            size_t i = 0;
+            for(; i + 4 <= size; i += 4)
+                _mm_storeu_ps(out + i, opSse2<TOp>(loadSse2(left, i), loadSse2(right, i)));
+            applyScalar<TOp>(left, right, out, i, size);
+        }
+
+        template<Fold TFold>
+        static float reduce(const float* in, size_t size)
+        {
+            if(size < LANES)
+                return reduceShort<TFold>(in, size);
+
+            auto low = _mm_loadu_ps(in);
+            auto high = _mm_loadu_ps(in + 4);
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+            {
+                low = foldSse2<TFold>(low, _mm_loadu_ps(in + i));
+                high = foldSse2<TFold>(high, _mm_loadu_ps(in + i + 4));
+            }
+
+            float lanes[LANES];
+            _mm_storeu_ps(lanes, low);
+            _mm_storeu_ps(lanes + 4, high);
+            return finish<TFold>(lanes, in, i, size);
+        }
+
+        static float dot(const float* left, const float* right, size_t size)
+        {
+            if(size < LANES)
+                return dotShort(left, right, size);
+
+            auto low = _mm_mul_ps(_mm_loadu_ps(left), _mm_loadu_ps(right));
+            auto high = _mm_mul_ps(_mm_loadu_ps(left + 4), _mm_loadu_ps(right + 4));
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+            {
+                low = _mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i)));
+                high = _mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(left + i + 4), _mm_loadu_ps(right + i + 4)));
+            }
+
+            float lanes[LANES];
+            _mm_storeu_ps(lanes, low);
+            _mm_storeu_ps(lanes + 4, high);
+            return finishDot(lanes, left, right, i, size);
+        }
+    };
+
+    __attribute__((target("avx2"))) __m256 loadAvx2(Elements in, size_t i) { return _mm256_loadu_ps(in.values + i); }
+    __attribute__((target("avx2"))) __m256 loadAvx2(Repeated in, size_t) { return _mm256_set1_ps(in.value); }
+
+    template<Op TOp>
+    __attribute__((target("avx2"))) __m256 opAvx2(__m256 l, __m256 r)
+    {
+        const auto one = _mm256_set1_ps(1.0f);
+        if constexpr (TOp == Op::Add)               return _mm256_add_ps(l, r);
+        else if constexpr (TOp == Op::Subtract)     return _mm256_sub_ps(l, r);
+        else if constexpr (TOp == Op::Multiply)     return _mm256_mul_ps(l, r);
+        else if constexpr (TOp == Op::Divide)       return _mm256_div_ps(l, r);
+        else if constexpr (TOp == Op::Equal)        return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_EQ_OQ), one);
+        else if constexpr (TOp == Op::NotEqual)     return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_NEQ_UQ), one);
+        else if constexpr (TOp == Op::Less)         return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_LT_OQ), one);
+        else if constexpr (TOp == Op::Greater)      return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_GT_OQ), one);
+        else if constexpr (TOp == Op::LessEqual)    return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_LE_OQ), one);
+        else                                        return _mm256_and_ps(_mm256_cmp_ps(l, r, _CMP_GE_OQ), one);
+    }
+
+    template<Fold TFold>
+    __attribute__((target("avx2"))) __m256 foldAvx2(__m256 acc, __m256 v)
+    {
+        if constexpr (TFold == Fold::Add)           return _mm256_add_ps(acc, v);
+        else if constexpr (TFold == Fold::Min)      return _mm256_min_ps(acc, v);
+        else                                        return _mm256_max_ps(acc, v);
+    }
+
+    // lanes 0-7 in one register
+    struct Avx2
+    {
+        template<Op TOp, typename TLeft, typename TRight>
+        __attribute__((target("avx2"))) static void apply(TLeft left, TRight right, float* out, size_t size)
+        {
+            size_t i = 0;
+            for(; i + 8 <= size; i += 8)
+                _mm256_storeu_ps(out + i, opAvx2<TOp>(loadAvx2(left, i), loadAvx2(right, i)));
+            applyScalar<TOp>(left, right, out, i, size);
+        }
+
+        template<Fold TFold>
+        __attribute__((target("avx2"))) static float reduce(const float* in, size_t size)
+        {
+            if(size < LANES)
+                return reduceShort<TFold>(in, size);
+
+            auto acc = _mm256_loadu_ps(in);
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+                acc = foldAvx2<TFold>(acc, _mm256_loadu_ps(in + i));
+
+            float lanes[LANES];
+            _mm256_storeu_ps(lanes, acc);
+            return finish<TFold>(lanes, in, i, size);
+        }
+
+        __attribute__((target("avx2"))) static float dot(const float* left, const float* right, size_t size)
+        {
+            if(size < LANES)
+                return dotShort(left, right, size);
+
+            // separate multiply and add, fused one would round differently than the other isas
+            auto acc = _mm256_mul_ps(_mm256_loadu_ps(left), _mm256_loadu_ps(right));
+            size_t i = LANES;
+            for(; i + LANES <= size; i += LANES)
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)));
+
+            float lanes[LANES];
+            _mm256_storeu_ps(lanes, acc);
+            return finishDot(lanes, left, right, i, size);
+        }
+    };
+#endif
+
+    template<typename TIsa, typename TLeft, typename TRight>
+    void applyWith(Op op, TLeft left, TRight right, float* out, size_t size)
+    {
+        switch(op)
+        {
+            case Op::Add:           return TIsa::template apply<Op::Add>(left, right, out, size);
+            case Op::Subtract:      return TIsa::template apply<Op::Subtract>(left, right, out, size);
+            case Op::Multiply:      return TIsa::template apply<Op::Multiply>(left, right, out, size);
+            case Op::Divide:        return TIsa::template apply<Op::Divide>(left, right, out, size);
+            case Op::Equal:         return TIsa::template apply<Op::Equal>(left, right, out, size);
+            case Op::NotEqual:      return TIsa::template apply<Op::NotEqual>(left, right, out, size);
+            case Op::Less:          return TIsa::template apply<Op::Less>(left, right, out, size);
+            case Op::Greater:       return TIsa::template apply<Op::Greater>(left, right, out, size);
+            case Op::LessEqual:     return TIsa::template apply<Op::LessEqual>(left, right, out, size);
+            case Op::GreaterEqual:  return TIsa::template apply<Op::GreaterEqual>(left, right, out, size);
+        }
+    }
+
+    struct Implementation
+    {
+        ArraySimd::Isa isa;
+        void (*apply)(Op, Elements, Elements, float*, size_t);
+        void (*applyRight)(Op, Elements, Repeated, float*, size_t);
+        void (*applyLeft)(Op, Repeated, Elements, float*, size_t);
+        float (*sum)(const float*, size_t);
+        float (*dot)(const float*, const float*, size_t);
+        float (*min)(const float*, size_t);
+        float (*max)(const float*, size_t);
+    };
+
+    template<typename TIsa>
+    Implementation implementationOf(ArraySimd::Isa isa)
+    {
+        return {
+            isa,
+            applyWith<TIsa, Elements, Elements>,
+            applyWith<TIsa, Elements, Repeated>,
+            applyWith<TIsa, Repeated, Elements>,
+            TIsa::template reduce<Fold::Add>,
+            TIsa::dot,
+            TIsa::template reduce<Fold::Min>,
+            TIsa::template reduce<Fold::Max>,
+        };
+    }
+
+    const Implementation& implementation()
+    {
+        static const Implementation selected = []() -> Implementation
+        {
+#ifdef QLANG_ARRAY_X86
+            if(__builtin_cpu_supports("avx2"))
+                return implementationOf<Avx2>(ArraySimd::Isa::Avx2);
+            return implementationOf<Sse2>(ArraySimd::Isa::Sse2);
+#else
+            return implementationOf<Scalar>(ArraySimd::Isa::Scalar);
+#endif
+        }();
+        return selected;
+    }
+}
+
+ArraySimd::Isa ArraySimd::selectedIsa()
+{
+    return implementation().isa;
+}
+
+void ArraySimd::apply(Op op, const float* left, const float* right, float* out, size_t size)
+{
+    implementation().apply(op, Elements{left}, Elements{right}, out, size);
+}
+
+void ArraySimd::applyRight(Op op, const float* left, float right, float* out, size_t size)
+{
+    implementation().applyRight(op, Elements{left}, Repeated{right}, out, size);
+}
+
+void ArraySimd::applyLeft(Op op, float left, const float* right, float* out, size_t size)
+{
+    implementation().applyLeft(op, Repeated{left}, Elements{right}, out, size);
+}
+
+float ArraySimd::sum(const float* in, size_t size)
+{
+    return size == 0 ? 0.0f : implementation().sum(in, size);
+}
+
+float ArraySimd::dot(const float* left, const float* right, size_t size)
+{
+    return size == 0 ? 0.0f : implementation().dot(left, right, size);
+}
+
+float ArraySimd::min(const float* in, size_t size)
+{
+    return implementation().min(in, size);
+}
+
+float ArraySimd::max(const float* in, size_t size)
+{
+    return implementation().max(in, size);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized element-wise kernels and reductions over float arrays for TemporaryValue::Array.
+// Implementation (AVX2, SSE2 or scalar) is selected once at runtime from what CPU supports.
+// Every implementation does the same float operations in the same order, so results do not depend on the machine.
+namespace ArraySimd
+{
+    enum class Isa { Scalar, Sse2, Avx2 };
+    Isa selectedIsa();
+
+    // comparisons give 1 for true and 0 for false
+    enum class Op : uint8_t
+    {
+        Add, Subtract, Multiply, Divide,
+        Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual
+    };
+
+    // out[i] = left[i] op right[i], out may be one of the inputs
+    void apply(Op op, const float* left, const float* right, float* out, size_t size);
+    // out[i] = left[i] op right
+    void applyRight(Op op, const float* left, float right, float* out, size_t size);
+    // out[i] = left op right[i]
+    void applyLeft(Op op, float left, const float* right, float* out, size_t size);
+
+    // accumulate in 8 interleaved lanes, combined after the last full group of 8
+    float sum(const float* in, size_t size);
+    float dot(const float* left, const float* right, size_t size);
+    // size must not be 0, NaN propagates as in minps/maxps
+    float min(const float* in, size_t size);
+    float max(const float* in, size_t size);
+}
@@ -1,75 +1,150 @@
 #include "AstNode.hpp"
 
+#include <algorithm>
+
 #include "vx.hpp"
 
-AstNode::OwnedNode AstNode::Identifier::copy() const
-{return std::make_unique<Identifier>(tokenValue);  }
+AstNode::Arena::~Arena()
+{
+    for(auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+        (*it)->~Base();
+}
 
-AstNode::OwnedNode AstNode::Integer::copy() const
-{return std::make_unique<Integer>(tokenValue); }
+void* AstNode::Arena::allocate(size_t size, size_t align)
+{
+    size_t offset = (blockUsed + align - 1) & ~(align - 1);
+    if(blocks.empty() || offset + size > blockSize)
+    {
+        blockSize = std::max(BLOCK_SIZE, size + align);
+        blocks.push_back(std::make_unique<std::byte[]>(blockSize));
+        offset = 0;
+    }
+    blockUsed = offset + size;
+    return blocks.back().get() + offset;
+}
 
-AstNode::OwnedNode AstNode::Float::copy() const
-{return std::make_unique<Float>(tokenValue); }
+static AstNode::NodeList copyList(const AstNode::NodeList& in, AstNode::Arena& arena)
+{
+    std::vector<AstNode::NodePtr> result;
+    result.reserve(in.size());
+    for (const auto& it: in)
+    {
+        result.push_back(it->copy(arena));
+    }
+    return arena.makeList(result);
+}
 
-AstNode::OwnedNode AstNode::Bool::copy() const
-{return std::make_unique<Bool>(tokenValue); }
+AstNode::NodePtr AstNode::Identifier::copy(Arena& arena) const
+{
+    auto ret = arena.make<Identifier>(tokenValue);
+    ret->depth = depth;
+    ret->slot = slot;
+    return ret;
+}
 
-AstNode::OwnedNode AstNode::String::copy() const
-{return std::make_unique<String>(tokenValue); }
+AstNode::NodePtr AstNode::Integer::copy(Arena& arena) const
+{return arena.make<Integer>(tokenValue); }
 
-AstNode::OwnedNode AstNode::UnaryOp::copy() const
-{return std::make_unique<UnaryOp>(tokenValue,inner->copy()); }
+AstNode::NodePtr AstNode::Float::copy(Arena& arena) const
+{return arena.make<Float>(tokenValue); }
 
-AstNode::OwnedNode AstNode::BinaryOp::copy() const
-{return std::make_unique<BinaryOp>(tokenValue,left->copy(),right->copy());}
+AstNode::NodePtr AstNode::Bool::copy(Arena& arena) const
+{return arena.make<Bool>(tokenValue); }
 
-AstNode::OwnedNode AstNode::Block::copy() const
+AstNode::String::String(const LexToken::String& inValue, Arena& arena) : BaseImpl<String>(), tokenValue(inValue), value(inValue.content)
 {
-    auto block = std::make_unique<Block>(std::vector<AstNode::OwnedNode>{});
-    for (const auto& statement: statements)
+    // '\n' is the only escape sequence, other backslashes are kept as written
+    if(value.find("\\n") == std::string_view::npos)
+        return;
+
+    std::string resolved;
+    resolved.reserve(value.size());
+    for(size_t i = 0; i != value.size(); i++)
     {
-        block->statements.push_back(statement->copy());
+        if(value[i] == '\\' && i+1 != value.size() && value[i+1] == 'n')
+        {
+            resolved += '\n';
+            i++;
+        }
+        else
+            resolved += value[i];
     }
+    value = arena.storeString(resolved);
+}
+
+AstNode::NodePtr AstNode::String::copy(Arena& arena) const
+{return arena.make<String>(tokenValue, arena); }
+
+AstNode::NodePtr AstNode::UnaryOp::copy(Arena& arena) const
+{return arena.make<UnaryOp>(tokenValue,inner->copy(arena)); }
+
+AstNode::NodePtr AstNode::BinaryOp::copy(Arena& arena) const
+{return arena.make<BinaryOp>(tokenValue,left->copy(arena),right->copy(arena));}
+
+AstNode::NodePtr AstNode::Block::copy(Arena& arena) const
+{
+    auto block = arena.make<Block>(copyList(statements,arena));
+    block->scopeSize = scopeSize;
     return block;
 }
 
-AstNode::OwnedNode AstNode::PrintStmt::copy() const
-{return std::make_unique<PrintStmt>(tokenValue,inner->copy()); }
+AstNode::NodePtr AstNode::PrintStmt::copy(Arena& arena) const
+{return arena.make<PrintStmt>(tokenValue,inner->copy(arena)); }
 
-AstNode::OwnedNode AstNode::IfStmt::copy() const
-{return std::make_unique<IfStmt>(tokenValue,when->copy(),then->copy(),elseThen->copy());}
+AstNode::NodePtr AstNode::IfStmt::copy(Arena& arena) const
+{
+    auto ret = arena.make<IfStmt>(tokenValue,when->copy(arena),then->copy(arena),elseThen ? elseThen->copy(arena) : nullptr);
+    ret->thenScopeSize = thenScopeSize;
+    ret->elseScopeSize = elseScopeSize;
+    return ret;
+}
 
-AstNode::OwnedNode AstNode::AssignStmt::copy() const
-{return std::make_unique<AssignStmt>(tokenValue,identifier->copy(),value->copy()); }
+AstNode::NodePtr AstNode::AssignStmt::copy(Arena& arena) const
+{return arena.make<AssignStmt>(tokenValue,identifier->copy(arena),value->copy(arena)); }
 
-AstNode::OwnedNode AstNode::WhileStmt::copy() const
-{return std::make_unique<WhileStmt>(tokenValue,until->copy(),loop->copy());}
+AstNode::NodePtr AstNode::WhileStmt::copy(Arena& arena) const
+{
+    auto ret = arena.make<WhileStmt>(tokenValue,until->copy(arena),loop->copy(arena));
+    ret->scopeSize = scopeSize;
+    return ret;
+}
 
-AstNode::OwnedNode AstNode::ForStmt::copy() const
-{return std::make_unique<ForStmt>(tokenValue,doOnce->copy(),until->copy(),afterIter->copy(),loop->copy());}
+AstNode::NodePtr AstNode::ForStmt::copy(Arena& arena) const
+{
+    auto ret = arena.make<ForStmt>(tokenValue,doOnce->copy(arena),until->copy(arena),afterIter->copy(arena),loop->copy(arena));
+    ret->scopeSize = scopeSize;
+    return ret;
+}
 
-AstNode::OwnedNode AstNode::FunctionDecl::copy() const
+AstNode::NodePtr AstNode::ParallelFor::copy(Arena& arena) const
 {
-    auto ret = std::make_unique<FunctionDecl>(tokenValue,std::vector<OwnedNode>{},body->copy());
-    for (const auto& p: params)
-    {
-        ret->params.push_back(p->copy());
-    }
+    auto ret = arena.make<ParallelFor>(tokenValue,index->copy(arena),begin->copy(arena),end->copy(arena),reduce,body->copy(arena));
+    ret->scopeSize = scopeSize;
     return ret;
 }
 
-AstNode::OwnedNode AstNode::FunctionCall::copy() const
+AstNode::NodePtr AstNode::FunctionDecl::copy(Arena& arena) const
 {
-    auto ret = std::make_unique<FunctionCall>(tokenValue,name->copy(),std::vector<OwnedNode>{});
-    for (const auto& p: args)
-    {
-        ret->args.push_back(p->copy());
-    }
+    auto ret = arena.make<FunctionDecl>(tokenValue,copyList(params,arena),body->copy(arena));
+    ret->scopeSize = scopeSize;
+    ret->sharedBody = sharedBody;
     return ret;
 }
 
-AstNode::OwnedNode AstNode::Return::copy() const
-{return std::make_unique<Return>(tokenValue,inner->copy()); }
+AstNode::NodePtr AstNode::ArrayLiteral::copy(Arena& arena) const
+{return arena.make<ArrayLiteral>(tokenValue,copyList(elements,arena)); }
+
+AstNode::NodePtr AstNode::Index::copy(Arena& arena) const
+{return arena.make<Index>(tokenValue,target->copy(arena),index->copy(arena)); }
+
+AstNode::NodePtr AstNode::BuiltinCall::copy(Arena& arena) const
+{return arena.make<BuiltinCall>(tokenValue,copyList(args,arena)); }
+
+AstNode::NodePtr AstNode::FunctionCall::copy(Arena& arena) const
+{return arena.make<FunctionCall>(tokenValue,name->copy(arena),copyList(args,arena)); }
+
+AstNode::NodePtr AstNode::Return::copy(Arena& arena) const
+{return arena.make<Return>(tokenValue,inner->copy(arena)); }
 
 struct PrinterVisitor : public AstNode::IVisitor
 {
@@ -85,7 +160,7 @@ struct PrinterVisitor : public AstNode::IVisitor
 
     void operator()(const AstNode::Identifier& v) override
     {
-        result = "Identifier{"+v.tokenValue.content+"} at "+v.tokenValue.source.stringify();
+        result = "Identifier{"+std::string(v.tokenValue.content)+"} at "+v.tokenValue.source.stringify();
     }
 
     void operator()(const AstNode::Integer& v) override
@@ -98,19 +173,19 @@ struct PrinterVisitor : public AstNode::IVisitor
     }
     void operator()(const AstNode::String& v) override
     {
-        result  ="String{"+v.tokenValue.content+"} at "+v.tokenValue.source.stringify();
+        result  ="String{"+std::string(v.tokenValue.content)+"} at "+v.tokenValue.source.stringify();
     }
 
     void operator()(const AstNode::Bool& v) override
     {
-        result = "Bool{"+v.tokenValue.content+"} at "+v.tokenValue.source.stringify();
+        result = "Bool{"+std::string(v.tokenValue.content)+"} at "+v.tokenValue.source.stringify();
     }
     void operator()(const AstNode::UnaryOp& v) override
     {
         result = "UnaryOp{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.inner, intend+1)+"\n";
         for(int i=0;i!=intend;i++) result+="\t";
@@ -121,13 +196,47 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "BinaryOp{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.left, intend+1)+",\n";
         result += stringify(*v.right, intend+1)+"\n";
         for(int i=0;i!=intend;i++) result+="\t";
         result += "}";
     }
+    void operator()(const AstNode::ArrayLiteral& v) override
+    {
+        result = "ArrayLiteral{\n";
+
+        for(int i=0;i!=intend+1;i++) result+="\t";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
+
+        for(auto& it : v.elements) result += stringify(*it, intend+1)+"\n";
+        for(int i=0;i!=intend;i++) result+="\t";
+        result += "}";
+    }
+    void operator()(const AstNode::Index& v) override
+    {
+        result = "Index{\n";
+
+        for(int i=0;i!=intend+1;i++) result+="\t";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
+
+        result += stringify(*v.target, intend+1)+",\n";
+        result += stringify(*v.index, intend+1)+"\n";
+        for(int i=0;i!=intend;i++) result+="\t";
+        result += "}";
+    }
+    void operator()(const AstNode::BuiltinCall& v) override
+    {
+        result = "BuiltinCall{\n";
+
+        for(int i=0;i!=intend+1;i++) result+="\t";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
+
+        for(auto& it : v.args) result += stringify(*it, intend+1)+"\n";
+        for(int i=0;i!=intend;i++) result+="\t";
+        result += "}";
+    }
     void operator()(const AstNode::Block& v) override
     {
         result = "Block{\n";
@@ -143,7 +252,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "PrintStmt{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.inner, intend+1)+"\n";
         for(int i=0;i!=intend;i++) result+="\t";
@@ -154,7 +263,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "IfStmt{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.when, intend+1)+",\n";
         result += stringify(*v.then, intend+1)+"\n";
@@ -168,7 +277,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "AssignStmt{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.identifier, intend+1)+",\n";
         result += stringify(*v.value, intend+1)+"\n";
@@ -180,7 +289,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "WhileStmt{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.until, intend+1)+",\n";
         result += stringify(*v.loop, intend+1)+"\n";
@@ -192,7 +301,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "ForStmt{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.doOnce, intend+1)+",\n";
         result += stringify(*v.until, intend+1)+"\n";
@@ -201,12 +310,31 @@ struct PrinterVisitor : public AstNode::IVisitor
         for(int i=0;i!=intend;i++) result+="\t";
         result += "}";
     }
+    void operator()(const AstNode::ParallelFor& v) override
+    {
+        result = "ParallelFor{\n";
+
+        for(int i=0;i!=intend+1;i++) result+="\t";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
+
+        result += stringify(*v.index, intend+1)+",\n";
+        result += stringify(*v.begin, intend+1)+",\n";
+        result += stringify(*v.end, intend+1)+",\n";
+        if(v.reduce)
+        {
+            for(int i=0;i!=intend+1;i++) result+="\t";
+            result += "reduce: "+std::string(v.reduce->content)+"\n";
+        }
+        result += stringify(*v.body, intend+1)+"\n";
+        for(int i=0;i!=intend;i++) result+="\t";
+        result += "}";
+    }
     void operator()(const AstNode::FunctionDecl& v) override
     {
         result = "FunctionDecl{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t"; result += "params: [";
         //for(auto& it : v.params) result += it.tokenValue.content + ",";
@@ -221,7 +349,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "FunctionCall{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         for(auto& it : v.args) result += stringify(*it);
 
@@ -233,7 +361,7 @@ struct PrinterVisitor : public AstNode::IVisitor
         result = "Return{\n";
 
         for(int i=0;i!=intend+1;i++) result+="\t";
-        result += v.tokenValue.content+" at "+v.tokenValue.source.stringify()+"\n";
+        result += std::string(v.tokenValue.content)+" at "+v.tokenValue.source.stringify()+"\n";
 
         result += stringify(*v.inner, intend+1)+"\n";
         for(int i=0;i!=intend;i++) result+="\t";
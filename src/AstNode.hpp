@@ -2,21 +2,27 @@
 
 #include <array>
 #include <memory>
-#include <regex>
+#include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "LexToken.hpp"
 #include "vx.hpp"
 
+namespace TemporaryValue { struct FuncBody; enum class OperandTypes : uint8_t; }
+
 namespace AstNode
 {
     struct Base;
     struct Identifier;
     struct Integer; struct Float; struct String; struct Bool;
-    struct UnaryOp; struct BinaryOp;
-    struct Block; struct PrintStmt; struct IfStmt; struct AssignStmt; struct WhileStmt; struct ForStmt; struct FunctionDecl; struct FunctionCall; struct Return;
+    struct UnaryOp; struct BinaryOp; struct ArrayLiteral; struct Index; struct BuiltinCall;
+    struct Block; struct PrintStmt; struct IfStmt; struct AssignStmt; struct WhileStmt; struct ForStmt; struct ParallelFor; struct FunctionDecl; struct FunctionCall; struct Return;
 
-    using OwnedNode = std::unique_ptr<Base>;
+    class Arena;
+    using NodePtr = Base*;                 // owned by Arena
+    using NodeList = std::span<NodePtr>;   // stored in Arena
 
 
     struct IVisitor
@@ -29,12 +35,16 @@ namespace AstNode
         virtual void operator()(const Bool&) =0;
         virtual void operator()(const UnaryOp&) =0;
         virtual void operator()(const BinaryOp&) =0;
+        virtual void operator()(const ArrayLiteral&) =0;
+        virtual void operator()(const Index&) =0;
+        virtual void operator()(const BuiltinCall&) =0;
         virtual void operator()(const Block&) =0;
         virtual void operator()(const PrintStmt&) =0;
         virtual void operator()(const IfStmt&) =0;
         virtual void operator()(const AssignStmt&) =0;
         virtual void operator()(const WhileStmt&) =0;
         virtual void operator()(const ForStmt&) =0;
+        virtual void operator()(const ParallelFor&) =0;
         virtual void operator()(const FunctionDecl&) =0;
         virtual void operator()(const FunctionCall&) =0;
         virtual void operator()(const Return&) =0;
@@ -45,7 +55,7 @@ namespace AstNode
         Base() = default;
         virtual ~Base() = default;
 
-        virtual OwnedNode copy() const = 0;
+        virtual NodePtr copy(Arena& arena) const = 0;
         virtual void accept(IVisitor&& visitor) const = 0;
     };
 
@@ -68,7 +78,11 @@ namespace AstNode
         };
         LexToken::Label tokenValue;
 
-        OwnedNode copy() const override;
+        // filled by AstResolver: number of scopes to walk up and slot index in that scope
+        mutable uint16_t depth {};
+        mutable uint32_t slot {};
+
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct Integer : public BaseImpl<Integer>
@@ -78,7 +92,7 @@ namespace AstNode
         };
         LexToken::Integer tokenValue;
 
-        OwnedNode copy() const override;;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct Float final : public BaseImpl<Float>
@@ -88,7 +102,7 @@ namespace AstNode
         };
         LexToken::Float tokenValue;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct Bool final : public BaseImpl<Bool>
@@ -98,75 +112,117 @@ namespace AstNode
         };
         LexToken::Label tokenValue;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct String final : public BaseImpl<String>
     {
-        explicit String(const LexToken::String& inValue) : BaseImpl<String>(), tokenValue(inValue)
-        {
-        };
+        // resolves escape sequences of the literal, copy with escapes is stored in arena
+        String(const LexToken::String& inValue, Arena& arena);
         LexToken::String tokenValue;
+        std::string_view value; // content as printed, views the source when literal has no escapes
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct UnaryOp final : public BaseImpl<UnaryOp>
     {
-        UnaryOp(const LexToken::Separator& inOp,OwnedNode inInner) : BaseImpl<UnaryOp>(),
+        UnaryOp(const LexToken::Separator& inOp,NodePtr inInner) : BaseImpl<UnaryOp>(),
             tokenValue(inOp), inner(std::move(inInner))
         {
         };
         LexToken::Separator tokenValue;
-        OwnedNode inner;
+        NodePtr inner;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
 
     };
 
     struct BinaryOp final : public BaseImpl<BinaryOp>
     {
-        BinaryOp(const LexToken::Separator& inOp, OwnedNode inLeft, OwnedNode inRight) :
+        BinaryOp(const LexToken::Separator& inOp, NodePtr inLeft, NodePtr inRight) :
             BaseImpl<BinaryOp>(), tokenValue(inOp), left(std::move(inLeft)), right(std::move(inRight))
         {
         };
         LexToken::Separator tokenValue;
-        OwnedNode left;
-        OwnedNode right;
+        NodePtr left;
+        NodePtr right;
+        mutable TemporaryValue::OperandTypes quickened {}; // recorded by the tree walker on first evaluation, through std::atomic_ref
+
+        NodePtr copy(Arena& arena) const override;
+    };
+
+    // value is TemporaryValue::Array of the elements, which must be numbers
+    struct ArrayLiteral final : public BaseImpl<ArrayLiteral>
+    {
+        ArrayLiteral(const LexToken::Separator& inOp, NodeList inElements) : BaseImpl<ArrayLiteral>(),
+            tokenValue(inOp), elements(std::move(inElements))
+        {
+        };
+        LexToken::Separator tokenValue;
+        NodeList elements;
+
+        NodePtr copy(Arena& arena) const override;
+    };
+
+    // element of Array target at Integer index
+    struct Index final : public BaseImpl<Index>
+    {
+        Index(const LexToken::Separator& inOp, NodePtr inTarget, NodePtr inIndex) : BaseImpl<Index>(),
+            tokenValue(inOp), target(std::move(inTarget)), index(std::move(inIndex))
+        {
+        };
+        LexToken::Separator tokenValue;
+        NodePtr target;
+        NodePtr index;
+
+        NodePtr copy(Arena& arena) const override;
+    };
+
+    // call of a function built into the language, named by tokenValue (TemporaryValue::toBuiltin)
+    struct BuiltinCall final : public BaseImpl<BuiltinCall>
+    {
+        BuiltinCall(const LexToken::Label& inName, NodeList inArgs) : BaseImpl<BuiltinCall>(),
+            tokenValue(inName), args(std::move(inArgs))
+        {
+        };
+        LexToken::Label tokenValue;
+        NodeList args;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct Block final : public BaseImpl<Block>
     {
-        explicit Block(std::vector<OwnedNode> inStatements) : BaseImpl<Block>(),
+        explicit Block(NodeList inStatements) : BaseImpl<Block>(),
             statements(std::move(inStatements))
         {
         }
 
-        std::vector<OwnedNode> statements;
+        NodeList statements;
+        mutable uint32_t scopeSize {}; // filled by AstResolver
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct PrintStmt final : public BaseImpl<PrintStmt>
     {
-        PrintStmt(const LexToken::Label& inOp,OwnedNode inInner) : BaseImpl<PrintStmt>(),
+        PrintStmt(const LexToken::Label& inOp,NodePtr inInner) : BaseImpl<PrintStmt>(),
             tokenValue(inOp), inner(std::move(inInner))
         {
         };
         LexToken::Label tokenValue;
-        OwnedNode inner;
+        NodePtr inner;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct IfStmt final : public BaseImpl<IfStmt>
     {
         IfStmt(const LexToken::Label& inOp,
-                OwnedNode when,
-                OwnedNode then,
-                OwnedNode elseThen)
+                NodePtr when,
+                NodePtr then,
+                NodePtr elseThen)
             : BaseImpl<IfStmt>(), tokenValue(inOp),
               when(std::move(when)),
               then(std::move(then)),
@@ -175,18 +231,20 @@ namespace AstNode
         };
 
         LexToken::Label tokenValue;
-        OwnedNode when;
-        OwnedNode then;
-        OwnedNode elseThen;
+        NodePtr when;
+        NodePtr then;
+        NodePtr elseThen;
+        mutable uint32_t thenScopeSize {}; // filled by AstResolver
+        mutable uint32_t elseScopeSize {}; // filled by AstResolver
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct AssignStmt final : public BaseImpl<AssignStmt>
     {
         AssignStmt(const LexToken::Separator& inOp,
-                OwnedNode inIdentifier,
-                OwnedNode inValue)
+                NodePtr inIdentifier,
+                NodePtr inValue)
             : BaseImpl<AssignStmt>(), tokenValue(inOp),
               identifier(std::move(inIdentifier)),
               value(std::move(inValue))
@@ -194,17 +252,17 @@ namespace AstNode
         };
 
         LexToken::Separator tokenValue;
-        OwnedNode identifier;
-        OwnedNode value;
+        NodePtr identifier;
+        NodePtr value;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct WhileStmt final : public BaseImpl<WhileStmt>
     {
         WhileStmt(const LexToken::Label& inOp,
-                OwnedNode until,
-                OwnedNode loop)
+                NodePtr until,
+                NodePtr loop)
             : BaseImpl<WhileStmt>(), tokenValue(inOp),
               until(std::move(until)),
               loop(std::move(loop))
@@ -212,19 +270,20 @@ namespace AstNode
         };
 
         LexToken::Label tokenValue;
-        OwnedNode until;
-        OwnedNode loop;
+        NodePtr until;
+        NodePtr loop;
+        mutable uint32_t scopeSize {}; // filled by AstResolver
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct ForStmt final : public BaseImpl<ForStmt>
     {
         ForStmt(const LexToken::Label& inOp,
-                OwnedNode doOnce,
-                OwnedNode until,
-                OwnedNode afterIter,
-                OwnedNode loop)
+                NodePtr doOnce,
+                NodePtr until,
+                NodePtr afterIter,
+                NodePtr loop)
             : BaseImpl<ForStmt>(), tokenValue(inOp),
               doOnce(std::move(doOnce)),
               until(std::move(until)),
@@ -234,19 +293,50 @@ namespace AstNode
         };
 
         LexToken::Label tokenValue;
-        OwnedNode doOnce;
-        OwnedNode until;
-        OwnedNode afterIter;
-        OwnedNode loop;
+        NodePtr doOnce;
+        NodePtr until;
+        NodePtr afterIter;
+        NodePtr loop;
+        mutable uint32_t scopeSize {}; // filled by AstResolver
+
+        NodePtr copy(Arena& arena) const override;
+    };
+
+    // iterations of index over integers [begin, end) run in parallel, each in its own scope,
+    // value is the combination of body values by reduce in order of iterations, false without reduce
+    struct ParallelFor final : public BaseImpl<ParallelFor>
+    {
+        ParallelFor(const LexToken::Label& inOp,
+                NodePtr index,
+                NodePtr begin,
+                NodePtr end,
+                std::optional<LexToken::Separator> reduce,
+                NodePtr body)
+            : BaseImpl<ParallelFor>(), tokenValue(inOp),
+              index(std::move(index)),
+              begin(std::move(begin)),
+              end(std::move(end)),
+              reduce(std::move(reduce)),
+              body(std::move(body))
+        {
+        };
 
-        OwnedNode copy() const override;
+        LexToken::Label tokenValue;
+        NodePtr index; // Identifier
+        NodePtr begin;
+        NodePtr end;
+        std::optional<LexToken::Separator> reduce; // '+', '*', '&&' or '||'
+        NodePtr body;
+        mutable uint32_t scopeSize {}; // filled by AstResolver, includes index
+
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct FunctionDecl final : public BaseImpl<FunctionDecl>
     {
         FunctionDecl(const LexToken::Separator& inOp,
-                std::vector<AstNode::OwnedNode> params,
-                OwnedNode body)
+                NodeList params,
+                NodePtr body)
             : BaseImpl<FunctionDecl>(), tokenValue(inOp),
               params(std::move(params)),
               body(std::move(body))
@@ -254,39 +344,86 @@ namespace AstNode
         };
 
         LexToken::Separator tokenValue;
-        std::vector<AstNode::OwnedNode> params;
-        OwnedNode body;
+        NodeList params;
+        NodePtr body;
+        mutable uint32_t scopeSize {}; // filled by AstResolver, includes params
+        mutable std::shared_ptr<const TemporaryValue::FuncBody> sharedBody {}; // created by AstResolver through TemporaryValue::FuncBody::of
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct FunctionCall final : public BaseImpl<FunctionCall>
     {
         FunctionCall(const LexToken::Separator& inOp,
-                OwnedNode name,
-                std::vector<OwnedNode> args)
+                NodePtr name,
+                NodeList args)
             : BaseImpl<FunctionCall>(), tokenValue(inOp), args(std::move(args)), name(std::move(name))
         {
         };
 
         LexToken::Separator tokenValue;
-        OwnedNode name;
-        std::vector<OwnedNode> args;
+        NodePtr name;
+        NodeList args;
 
-        OwnedNode copy() const override;
+        NodePtr copy(Arena& arena) const override;
     };
 
     struct Return final : public BaseImpl<Return>
     {
-        Return(const LexToken::Label& inOp,OwnedNode inInner) : BaseImpl<Return>(),
+        Return(const LexToken::Label& inOp,NodePtr inInner) : BaseImpl<Return>(),
             tokenValue(inOp), inner(std::move(inInner))
         {
         };
         LexToken::Label tokenValue;
-        OwnedNode inner;
+        NodePtr inner;
+
+        NodePtr copy(Arena& arena) const override;
+
+    };
+
+    // Owns all nodes of one parse. Nodes are bump allocated next to each other in big blocks
+    // and released together when arena is destroyed, instead of one heap allocation per node.
+    class Arena
+    {
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena();
+
+        template<typename T, typename... TArgs>
+        T* make(TArgs&&... args)
+        {
+            auto node = new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+            nodes.push_back(node);
+            return node;
+        }
+
+        NodeList makeList(const std::vector<NodePtr>& in)
+        {
+            auto list = static_cast<NodePtr*>(allocate(sizeof(NodePtr) * in.size(), alignof(NodePtr)));
+            std::copy(in.begin(), in.end(), list);
+            return {list, in.size()};
+        }
+
+        std::string_view storeString(std::string_view in)
+        {
+            auto chars = static_cast<char*>(allocate(in.size(), alignof(char)));
+            std::copy(in.begin(), in.end(), chars);
+            return {chars, in.size()};
+        }
+
+        size_t nodeCount() const { return nodes.size(); }
+
+    protected:
+        void* allocate(size_t size, size_t align);
 
-        OwnedNode copy() const override;
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
 
+        std::vector<std::unique_ptr<std::byte[]>> blocks {};
+        size_t blockUsed {};
+        size_t blockSize {};
+        std::vector<Base*> nodes {}; // destroyed in reverse order of creation
     };
 
     std::string stringify(const Base& in, int intend = 0);
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <optional>
+
+#include "AstNode.hpp"
+#include "TemporaryValue.hpp"
+
+// Rewrites parsed tree before AstResolver runs:
+// folds UnaryOp/BinaryOp of literals, replaces IfStmt/WhileStmt with a literal condition by the branch that runs
+// and drops 'c && true', 'c || false' when c is Bool without running the program.
+// Rewrites never change output or errors of a program, so e.g. integer division by zero is left for runtime.
+class AstOptimizer
+{
+public:
+    explicit AstOptimizer(AstNode::Arena& inArena) : arena(inArena) {};
+
+    // returns node to use in place of in, children are rewritten in place
+    AstNode::NodePtr optimize(AstNode::NodePtr in)
+    {
+        if(auto v = dynamic_cast<AstNode::UnaryOp*>(in))
+        {
+            v->inner = optimize(v->inner);
+            return optimizeUnary(*v);
+        }
+        if(auto v = dynamic_cast<AstNode::BinaryOp*>(in))
+        {
+            v->left = optimize(v->left);
+            v->right = optimize(v->right);
+            return optimizeBinary(*v);
+        }
+        if(auto v = dynamic_cast<AstNode::ArrayLiteral*>(in))
+        {
+            for(auto& it : v->elements)
+                it = optimize(it);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::Index*>(in))
+        {
+            v->target = optimize(v->target);
+            v->index = optimize(v->index);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::BuiltinCall*>(in))
+        {
+            for(auto& it : v->args)
+                it = optimize(it);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::Block*>(in))
+        {
+            for(auto& it : v->statements)
+                it = optimize(it);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::PrintStmt*>(in))
+        {
+            v->inner = optimize(v->inner);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::IfStmt*>(in))
+        {
+            v->when = optimize(v->when);
+            v->then = optimize(v->then);
+            if(v->elseThen)
+                v->elseThen = optimize(v->elseThen);
+
+            if(auto when = constantOf(v->when); when && when->is<TemporaryValue::Bool>())
+            {
+                // block around the branch gives it its own scope, same as IfStmt does
+                if(when->as<TemporaryValue::Bool>().value)
+                    return arena.make<AstNode::Block>(arena.makeList({v->then}));
+                if(v->elseThen)
+                    return arena.make<AstNode::Block>(arena.makeList({v->elseThen}));
+                return makeConstant(TemporaryValue::Bool{false}, v->tokenValue.source);
+            }
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::AssignStmt*>(in))
+        {
+            v->value = optimize(v->value);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::WhileStmt*>(in))
+        {
+            v->until = optimize(v->until);
+            v->loop = optimize(v->loop);
+
+            if(auto until = constantOf(v->until); until && until->is<TemporaryValue::Bool>() && !until->as<TemporaryValue::Bool>().value)
+                return makeConstant(TemporaryValue::Bool{false}, v->tokenValue.source);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::ForStmt*>(in))
+        {
+            v->doOnce = optimize(v->doOnce);
+            v->until = optimize(v->until);
+            v->afterIter = optimize(v->afterIter);
+            v->loop = optimize(v->loop);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::ParallelFor*>(in))
+        {
+            v->begin = optimize(v->begin);
+            v->end = optimize(v->end);
+            v->body = optimize(v->body);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::FunctionDecl*>(in))
+        {
+            v->body = optimize(v->body);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::FunctionCall*>(in))
+        {
+            for(auto& it : v->args)
+                it = optimize(it);
+            return v;
+        }
+        if(auto v = dynamic_cast<AstNode::Return*>(in))
+        {
+            v->inner = optimize(v->inner);
+            return v;
+        }
+        return in;
+    }
+
+protected:
+    using Tag = TemporaryValue::Any::Tag;
+
+    static std::optional<TemporaryValue::Any> constantOf(AstNode::NodePtr in)
+    {
+        if(auto v = dynamic_cast<const AstNode::Integer*>(in))
+            return TemporaryValue::Integer{v->tokenValue.content};
+        if(auto v = dynamic_cast<const AstNode::Float*>(in))
+            return TemporaryValue::Float{v->tokenValue.content};
+        if(auto v = dynamic_cast<const AstNode::Bool*>(in))
+            return TemporaryValue::Bool{v->tokenValue.keyword == LexToken::Keyword::True};
+        if(auto v = dynamic_cast<const AstNode::String*>(in))
+            return TemporaryValue::String{std::string(v->value)};
+        return {};
+    }
+
+    // Bool whenever evaluation succeeds, types of identifiers are unknown as the pass runs before AstResolver
+    static bool isBool(AstNode::NodePtr in)
+    {
+        if(dynamic_cast<const AstNode::Bool*>(in))
+            return true;
+        if(auto v = dynamic_cast<const AstNode::UnaryOp*>(in))
+            return v->tokenValue.kind == LexToken::SeparatorKind::Bang;
+        if(auto v = dynamic_cast<const AstNode::BinaryOp*>(in))
+            return v->tokenValue.kind == LexToken::SeparatorKind::AndAnd || v->tokenValue.kind == LexToken::SeparatorKind::OrOr;
+        return false;
+    }
+
+    static bool isLiteral(AstNode::NodePtr in, const TemporaryValue::Any& expected)
+    {
+        auto value = constantOf(in);
+        if(!value || value->getTag() != expected.getTag())
+            return false;
+        auto equal = TemporaryValue::binaryOp(TemporaryValue::BinaryOperator::Equal, *value, expected);
+        return equal && TemporaryValue::getBool(*equal);
+    }
+
+    // nullptr for values without literal node (String result would need storage outside of the source)
+    AstNode::NodePtr makeConstant(const TemporaryValue::Any& value, const LexToken::Source& source)
+    {
+        switch(value.getTag())
+        {
+            case Tag::Bool:
+            {
+                const bool asBool = value.as<TemporaryValue::Bool>().value;
+                return arena.make<AstNode::Bool>(LexToken::Label{source, asBool ? "true" : "false", asBool ? LexToken::Keyword::True : LexToken::Keyword::False});
+            }
+            case Tag::Integer:  return arena.make<AstNode::Integer>(LexToken::Integer{source, value.as<TemporaryValue::Integer>().value});
+            case Tag::Float:    return arena.make<AstNode::Float>(LexToken::Float{source, value.as<TemporaryValue::Float>().value});
+            default:            return nullptr;
+        }
+    }
+
+    AstNode::NodePtr optimizeUnary(AstNode::UnaryOp& v)
+    {
+        const auto op = TemporaryValue::toUnaryOperator(v.tokenValue.kind);
+        if(!op)
+            return &v;
+
+        if(auto inner = constantOf(v.inner))
+        {
+            if(auto folded = makeConstant(TemporaryValue::unaryOp(*op, *inner), v.tokenValue.source))
+                return folded;
+        }
+        return &v;
+    }
+
+    AstNode::NodePtr optimizeBinary(AstNode::BinaryOp& v)
+    {
+        const auto left = constantOf(v.left);
+        const auto right = constantOf(v.right);
+        const auto& source = v.tokenValue.source;
+
+        if(v.tokenValue.kind == LexToken::SeparatorKind::AndAnd || v.tokenValue.kind == LexToken::SeparatorKind::OrOr)
+        {
+            const bool isAnd = v.tokenValue.kind == LexToken::SeparatorKind::AndAnd;
+            if(!left || !left->is<TemporaryValue::Bool>())
+            {
+                // 'c && true', 'c || false'
+                if(isBool(v.left) && isLiteral(v.right, TemporaryValue::Bool{isAnd}))
+                    return v.left;
+                return &v;
+            }
+
+            // right side is skipped at runtime too
+            if(left->as<TemporaryValue::Bool>().value != isAnd)
+                return makeConstant(*left, source);
+            if(right && right->is<TemporaryValue::Bool>())
+                return makeConstant(*right, source);
+            if(isBool(v.right))
+                return v.right;
+            return &v;
+        }
+
+        const auto op = TemporaryValue::toBinaryOperator(v.tokenValue.kind);
+        if(!op || !left || !right || !canFold(*op, *left, *right))
+            return &v;
+
+        if(auto value = TemporaryValue::binaryOp(*op, *left, *right))
+        {
+            if(auto folded = makeConstant(*value, source))
+                return folded;
+        }
+        return &v;
+    }
+
+    // leaves operations which would stop the program at runtime
+    static bool canFold(TemporaryValue::BinaryOperator op, const TemporaryValue::Any& left, const TemporaryValue::Any& right)
+    {
+        using TemporaryValue::BinaryOperator;
+        if(left.is<TemporaryValue::Bool>() && (op == BinaryOperator::Equal || op == BinaryOperator::NotEqual))
+            return right.is<TemporaryValue::Bool>();
+
+        if(left.is<TemporaryValue::Integer>() && right.is<TemporaryValue::Integer>() && (op == BinaryOperator::Divide || op == BinaryOperator::Modulo))
+        {
+            return !TemporaryValue::integerDivisionFails(left.as<TemporaryValue::Integer>().value, right.as<TemporaryValue::Integer>().value);
+        }
+        return true;
+    }
+
+    AstNode::Arena& arena;
+};
@@ -2,52 +2,54 @@
 
 #include <memory>
 
-#include "LexScanner.hpp"
+#include "LexTokenBuffer.hpp"
 #include "AstNode.hpp"
+#include "Diagnostics.hpp"
+#include "TemporaryValue.hpp"
 
 class AstParser
 {
 public:
-    explicit AstParser(LexScanner& inScanner) : scanner(inScanner) {};
+    AstParser(LexTokenBuffer& inTokens, AstNode::Arena& inArena) : tokens(inTokens), arena(inArena) {};
 
     //<identifier> ::= <label> | <label> '(' <arg>? (',' <arg>)*
-    AstNode::OwnedNode identifier()
+    AstNode::NodePtr identifier()
     {
 
-        if(const auto v = scanner.current<LexToken::Label>())
+        if(const auto v = tokens.current<LexToken::Label>())
         {
-            scanner.next();
-            auto id = std::make_unique<AstNode::Identifier>(*v);
+            tokens.next();
+            auto id = arena.make<AstNode::Identifier>(*v);
 
 
-            if(const auto v = scanner.currentMath<LexToken::Separator>("("))
+            if(const auto v = tokens.currentMath(LexToken::SeparatorKind::OpenParen))
             {
-                std::vector<AstNode::OwnedNode> args;
-                scanner.next();
+                std::vector<AstNode::NodePtr> args;
+                tokens.next();
 
-                if (auto el = scanner.currentMath<LexToken::Separator>(")"))
+                if (auto el = tokens.currentMath(LexToken::SeparatorKind::CloseParen))
                 {
-                    scanner.next();
-                    return std::make_unique<AstNode::FunctionCall>(*v,std::move(id),std::move(args));
+                    tokens.next();
+                    return arena.make<AstNode::FunctionCall>(*v,std::move(id),arena.makeList(args));
                 }
                 else
                 {
                     args.push_back(std::move(expr()));
-                    while (scanner.currentMath<LexToken::Separator>(",") )
+                    while (tokens.currentMath(LexToken::SeparatorKind::Comma) )
                     {
-                        scanner.next();
+                        tokens.next();
 
                         args.push_back(std::move(expr()));
                     }
 
-                    if (auto el = scanner.currentMath<LexToken::Separator>(")") ; !el )
+                    if (auto el = tokens.currentMath(LexToken::SeparatorKind::CloseParen) ; !el )
                     {
-                        std::cout << "\nCRITICAL PARSER ERROR: mising ')' in function declaration " << LexToken::printHint(*v) << "opened here" << std::endl;
+                        diagnostics() << "\nCRITICAL PARSER ERROR: mising ')' in function declaration " << LexToken::printHint(*v) << "opened here" << std::endl;
                         throw std::runtime_error("");
                     }
-                    scanner.next();
+                    tokens.next();
 
-                    return std::make_unique<AstNode::FunctionCall>(*v,std::move(id),std::move(args));
+                    return arena.make<AstNode::FunctionCall>(*v,std::move(id),arena.makeList(args));
                 }
             }
             else
@@ -56,163 +58,194 @@ public:
             }
         }
 
-        std::cout << "\nCRITICAL PARSER ERROR: couldn't parse as identifier " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "'in the end of file'") << " unexpected token" << std::endl;
+        diagnostics() << "\nCRITICAL PARSER ERROR: couldn't parse as identifier " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "'in the end of file'") << " unexpected token" << std::endl;
         throw std::runtime_error("");
     }
 
-    //<primary> ::= <identifier> | <integer> | <float> | <string> | <function> |  <bool> as ('true'|'false') | '(' <expr> ')'
-    AstNode::OwnedNode primary()
+    //<primary> ::= <identifier> | <integer> | <float> | <string> | <function> | <pfor> | <array> | <builtin> |  <bool> as ('true'|'false') | '(' <expr> ')'
+    AstNode::NodePtr primary()
     {
-        if(const auto v = scanner.current<LexToken::Integer>())
+        if(const auto v = tokens.current<LexToken::Integer>())
         {
-            scanner.next();
-            return std::make_unique<AstNode::Integer>(*v);
+            tokens.next();
+            return arena.make<AstNode::Integer>(*v);
         }
-        if(const auto v =scanner.current<LexToken::Float>())
+        if(const auto v =tokens.current<LexToken::Float>())
         {
-            scanner.next();
-            return std::make_unique<AstNode::Float>(*v);
+            tokens.next();
+            return arena.make<AstNode::Float>(*v);
         }
-        if(const auto v =scanner.current<LexToken::String>())
+        if(const auto v =tokens.current<LexToken::String>())
         {
-            scanner.next();
-            return std::make_unique<AstNode::String>(*v);
+            tokens.next();
+            return arena.make<AstNode::String>(*v, arena);
         }
 
-        if(scanner.currentMath<LexToken::Label>("true") || scanner.currentMath<LexToken::Label>("false"))
+        if(tokens.currentMath(LexToken::Keyword::True) || tokens.currentMath(LexToken::Keyword::False))
         {
-            const auto v = *scanner.current<LexToken::Label>();
-            scanner.next();
-            return std::make_unique<AstNode::Bool>(v);
+            const auto v = *tokens.current<LexToken::Label>();
+            tokens.next();
+            return arena.make<AstNode::Bool>(v);
         }
-        else if(scanner.current<LexToken::Label>())
+        else if(tokens.currentMath(LexToken::Keyword::Pfor))
+        {
+            return std::move(parallelFor());
+        }
+        else if(const auto v = tokens.current<LexToken::Label>(); v && TemporaryValue::toBuiltin(v->content) && tokens.peekMath(1, LexToken::SeparatorKind::OpenParen))
+        {
+            return std::move(builtin());
+        }
+        else if(tokens.current<LexToken::Label>())
         {
             return std::move(identifier());
         }
-        if(auto open = scanner.currentMath<LexToken::Separator>("fn"))
+        if(auto open = tokens.currentMath(LexToken::SeparatorKind::Fn))
         {
             return std::move(function());
         }
-        if(auto open = scanner.currentMath<LexToken::Separator>("("))
+        if(tokens.currentMath(LexToken::SeparatorKind::OpenBracket))
         {
-            scanner.next();
-            std::unique_ptr<AstNode::Base> e = std::move(expr());
-            if(scanner.currentMath<LexToken::Separator>(")"))
+            return std::move(array());
+        }
+        if(auto open = tokens.currentMath(LexToken::SeparatorKind::OpenParen))
+        {
+            tokens.next();
+            AstNode::NodePtr e = std::move(expr());
+            if(tokens.currentMath(LexToken::SeparatorKind::CloseParen))
             {
-                scanner.next();
+                tokens.next();
             }
             else
             {
-                std::cout << "\nCRITICAL PARSER ERROR: expected closing parentheses, opened " << LexToken::printHint(*open) << " not found closing ')'" << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected closing parentheses, opened " << LexToken::printHint(*open) << " not found closing ')'" << std::endl;
                 throw std::runtime_error("");
             }
 
             return e;
         }
-        std::cout << "\nCRITICAL PARSER ERROR: couldn't parse as primary " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "'in the end of file'") << " unexpected token" << std::endl;
+        diagnostics() << "\nCRITICAL PARSER ERROR: couldn't parse as primary " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "'in the end of file'") << " unexpected token" << std::endl;
         throw std::runtime_error("");
     }
 
-    //<unary> ::= ('+'|'-'|'!') <unary> | <primary>
-    AstNode::OwnedNode unary()
+    //<postfix> ::= <primary> ( '[' <expr> ']' )*
+    AstNode::NodePtr postfix()
     {
-        if(scanner.currentMath<LexToken::Separator>("+") || scanner.currentMath<LexToken::Separator>("-") || scanner.currentMath<LexToken::Separator>("!"))
+        auto target = std::move(primary());
+        while(auto open = tokens.currentMath(LexToken::SeparatorKind::OpenBracket))
         {
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            tokens.next();
+            auto index = std::move(expr());
+            if(!tokens.currentMath(LexToken::SeparatorKind::CloseBracket))
+            {
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected closing bracket, opened " << LexToken::printHint(*open) << " not found closing ']'" << std::endl;
+                throw std::runtime_error("");
+            }
+            tokens.next();
+            target = arena.make<AstNode::Index>(*open,std::move(target),std::move(index));
+        }
+        return target;
+    }
+
+    //<unary> ::= ('+'|'-'|'!') <unary> | <postfix>
+    AstNode::NodePtr unary()
+    {
+        if(tokens.currentMath(LexToken::SeparatorKind::Plus) || tokens.currentMath(LexToken::SeparatorKind::Minus) || tokens.currentMath(LexToken::SeparatorKind::Bang))
+        {
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto inner = std::move(unary());
-            return std::make_unique<AstNode::UnaryOp>(op, std::move(inner));
+            return arena.make<AstNode::UnaryOp>(op, std::move(inner));
         }
-        return primary();
+        return postfix();
     }
 
     //<exponent> ::= <unary> ( ('^') <exponent> )*
-    AstNode::OwnedNode exponent()
+    AstNode::NodePtr exponent()
     {
         auto e = unary();
-        while (scanner.currentMath<LexToken::Separator>("^") )
+        while (tokens.currentMath(LexToken::SeparatorKind::Caret) )
         {
 
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto right = std::move(exponent());
-            e = std::make_unique<AstNode::BinaryOp>(op, std::move(e), std::move(right));
+            e = arena.make<AstNode::BinaryOp>(op, std::move(e), std::move(right));
 
         }
         return std::move(e);
     }
 
     //<multiplication> ::= <exponent> ( ('+' | '-') <exponent> )*
-    AstNode::OwnedNode multiplication()
+    AstNode::NodePtr multiplication()
     {
         auto e = exponent();
-        while (scanner.currentMath<LexToken::Separator>("*") || scanner.currentMath<LexToken::Separator>("/") || scanner.currentMath<LexToken::Separator>("%") )
+        while (tokens.currentMath(LexToken::SeparatorKind::Star) || tokens.currentMath(LexToken::SeparatorKind::Slash) || tokens.currentMath(LexToken::SeparatorKind::Percent) )
         {
 
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto right = std::move(exponent());
-            e = std::make_unique<AstNode::BinaryOp>(op, std::move(e), std::move(right));
+            e = arena.make<AstNode::BinaryOp>(op, std::move(e), std::move(right));
 
         }
         return std::move(e);
     }
 
     //<addition> ::= <multiplication> ( ('+' | '-') <multiplication> )*
-    AstNode::OwnedNode addition()
+    AstNode::NodePtr addition()
     {
         auto e = multiplication();
 
-        while (scanner.currentMath<LexToken::Separator>("+") || scanner.currentMath<LexToken::Separator>("-") )
+        while (tokens.currentMath(LexToken::SeparatorKind::Plus) || tokens.currentMath(LexToken::SeparatorKind::Minus) )
         {
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto right = std::move(multiplication());
-            e = std::make_unique<AstNode::BinaryOp>(op, std::move(e), std::move(right));
+            e = arena.make<AstNode::BinaryOp>(op, std::move(e), std::move(right));
 
         }
         return std::move(e);
     }
 
     //<comparison> ::= <addition> ( ('==' | '!=' | '<' | '>' | '<=' | '>=' ) <addition> )*
-    AstNode::OwnedNode comparison()
+    AstNode::NodePtr comparison()
     {
         auto e = addition();
 
-        while (scanner.currentMath<LexToken::Separator>("==")
-            || scanner.currentMath<LexToken::Separator>("!=")
-            || scanner.currentMath<LexToken::Separator>("<")
-            || scanner.currentMath<LexToken::Separator>(">")
-            || scanner.currentMath<LexToken::Separator>("<=")
-            || scanner.currentMath<LexToken::Separator>(">="))
+        while (tokens.currentMath(LexToken::SeparatorKind::EqualEqual)
+            || tokens.currentMath(LexToken::SeparatorKind::BangEqual)
+            || tokens.currentMath(LexToken::SeparatorKind::Less)
+            || tokens.currentMath(LexToken::SeparatorKind::Greater)
+            || tokens.currentMath(LexToken::SeparatorKind::LessEqual)
+            || tokens.currentMath(LexToken::SeparatorKind::GreaterEqual))
         {
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto right = std::move(addition());
-            e = std::make_unique<AstNode::BinaryOp>(op, std::move(e), std::move(right));
+            e = arena.make<AstNode::BinaryOp>(op, std::move(e), std::move(right));
 
         }
         return std::move(e);
     }
 
     //<logic> ::= <comparison> ( ('&&'|'||') <comparison> )*
-    AstNode::OwnedNode logic()
+    AstNode::NodePtr logic()
     {
         auto e = comparison();
 
-        while (scanner.currentMath<LexToken::Separator>("&&")
-            || scanner.currentMath<LexToken::Separator>("||"))
+        while (tokens.currentMath(LexToken::SeparatorKind::AndAnd)
+            || tokens.currentMath(LexToken::SeparatorKind::OrOr))
         {
-            auto op = *scanner.current<LexToken::Separator>();
-            scanner.next();
+            auto op = *tokens.current<LexToken::Separator>();
+            tokens.next();
 
             auto right = std::move(comparison());
-            e = std::make_unique<AstNode::BinaryOp>(op, std::move(e), std::move(right));
+            e = arena.make<AstNode::BinaryOp>(op, std::move(e), std::move(right));
 
         }
         return std::move(e);
@@ -220,204 +253,310 @@ public:
 
 
     //<expr> ::= <logic>
-    AstNode::OwnedNode expr()
+    AstNode::NodePtr expr()
     {
         return logic();
     }
 
     //<assigment> ::= <expr> ':=' <expr> | <identifier> '(' | <function>
-    AstNode::OwnedNode assigment()
+    AstNode::NodePtr assigment()
     {
-        if (auto t= scanner.currentMath<LexToken::Separator>("fn"))
+        if (auto t= tokens.currentMath(LexToken::SeparatorKind::Fn))
         {
             return std::move(function());
         }
-        else if (auto t= scanner.current<LexToken::Label>() ) // <assigment>
+        else if (auto t= tokens.current<LexToken::Label>() ) // <assigment>
         {
             auto id = std::move(expr());
 
-            auto el = scanner.currentMath<LexToken::Separator>(":=");
+            auto el = tokens.currentMath(LexToken::SeparatorKind::ColonEqual);
             if (!el)
             {
                 return std::move(id);
             }
-            scanner.next();
+            tokens.next();
 
             auto ex = std::move(expr());
 
-            return std::make_unique<AstNode::AssignStmt>(*el,std::move(id),std::move(ex));
+            return arena.make<AstNode::AssignStmt>(*el,std::move(id),std::move(ex));
         }
-        std::cout << "\nCRITICAL PARSER ERROR: couldn't parse as assigment " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "'in the end of file'") << " unexpected token" << std::endl;
+        diagnostics() << "\nCRITICAL PARSER ERROR: couldn't parse as assigment " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "'in the end of file'") << " unexpected token" << std::endl;
         throw std::runtime_error("");
     }
 
     //<stmt> ::= 'print' <expr> | 'if' <expr> <stmt> ( 'else' <stmt> )? | 'while' <expr> <stmt> | 'for' '(' <assigment> ',' <expr> ',' <assigment> ')'  <stmt> | <identifier> := <expr> | '{' <stmt>* '}'
-    AstNode::OwnedNode stmt()
+    AstNode::NodePtr stmt()
     {
-        if (auto t= scanner.currentMath<LexToken::Label>("print") )
+        if (auto t= tokens.currentMath(LexToken::Keyword::Print) )
         {
-            scanner.next();
+            tokens.next();
             auto e = std::move(expr());
-            return std::make_unique<AstNode::PrintStmt>(*t,std::move(e));
+            return arena.make<AstNode::PrintStmt>(*t,std::move(e));
         }
-        else if (auto t= scanner.currentMath<LexToken::Label>("if") )
+        else if (auto t= tokens.currentMath(LexToken::Keyword::If) )
         {
-            scanner.next();
+            tokens.next();
             auto ex = std::move(expr());
             auto st = std::move(stmt());
 
-            if (auto el = scanner.currentMath<LexToken::Label>("else") )
+            if (auto el = tokens.currentMath(LexToken::Keyword::Else) )
             {
-                scanner.next();
+                tokens.next();
                 auto elSt = std::move(stmt());
-                return std::make_unique<AstNode::IfStmt>(*t,std::move(ex),std::move(st),std::move(elSt));
+                return arena.make<AstNode::IfStmt>(*t,std::move(ex),std::move(st),std::move(elSt));
             }
-            return std::make_unique<AstNode::IfStmt>(*t,std::move(ex),std::move(st),nullptr);
+            return arena.make<AstNode::IfStmt>(*t,std::move(ex),std::move(st),nullptr);
         }
-        else if (auto t= scanner.currentMath<LexToken::Label>("while") )
+        else if (auto t= tokens.currentMath(LexToken::Keyword::While) )
         {
-            scanner.next();
+            tokens.next();
             auto until = std::move(expr());
             auto loop = std::move(stmt());
-            return std::make_unique<AstNode::WhileStmt>(*t,std::move(until),std::move(loop));
+            return arena.make<AstNode::WhileStmt>(*t,std::move(until),std::move(loop));
         }
-        else if (auto t= scanner.currentMath<LexToken::Label>("for") )
+        else if (auto t= tokens.currentMath(LexToken::Keyword::For) )
         {
-            scanner.next();
+            tokens.next();
 
-            if (auto el = scanner.currentMath<LexToken::Separator>("(") ; !el )
+            if (auto el = tokens.currentMath(LexToken::SeparatorKind::OpenParen) ; !el )
             {
-                std::cout << "\nCRITICAL PARSER ERROR: expected '(' if for loop statement " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected '(' if for loop statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
                 throw std::runtime_error("");
             }
-            scanner.next();
+            tokens.next();
 
             auto doOnce = std::move(assigment());
 
-            if (auto el = scanner.currentMath<LexToken::Separator>(",") ; !el )
+            if (auto el = tokens.currentMath(LexToken::SeparatorKind::Comma) ; !el )
             {
-                std::cout << "\nCRITICAL PARSER ERROR: expected ',' if for loop statement " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected ',' if for loop statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
                 throw std::runtime_error("");
             }
-            scanner.next();
+            tokens.next();
 
             auto until = std::move(expr());
 
-            if (auto el = scanner.currentMath<LexToken::Separator>(",") ; !el )
+            if (auto el = tokens.currentMath(LexToken::SeparatorKind::Comma) ; !el )
             {
-                std::cout << "\nCRITICAL PARSER ERROR: expected ',' if for loop statement " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected ',' if for loop statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
                 throw std::runtime_error("");
             }
-            scanner.next();
+            tokens.next();
 
             auto after = std::move(assigment());
 
-            if (auto el = scanner.currentMath<LexToken::Separator>(")") ; !el )
+            if (auto el = tokens.currentMath(LexToken::SeparatorKind::CloseParen) ; !el )
             {
-                std::cout << "\nCRITICAL PARSER ERROR: expected ')' if for loop statement " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected ')' if for loop statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
                 throw std::runtime_error("");
             }
-            scanner.next();
+            tokens.next();
 
             auto st = std::move(stmt());
 
-            return std::make_unique<AstNode::ForStmt>(*t,std::move(doOnce),std::move(until),std::move(after),std::move(st));
+            return arena.make<AstNode::ForStmt>(*t,std::move(doOnce),std::move(until),std::move(after),std::move(st));
         }
-        else if (auto t= scanner.currentMath<LexToken::Label>("ret") )
+        else if (auto t= tokens.currentMath(LexToken::Keyword::Ret) )
         {
-            scanner.next();
+            tokens.next();
             auto e = std::move(expr());
-            return std::make_unique<AstNode::Return>(*t,std::move(e));
+            return arena.make<AstNode::Return>(*t,std::move(e));
         }
-        else if (auto t= scanner.current<LexToken::Label>() ) // <assigment>
+        else if (auto t= tokens.current<LexToken::Label>() ) // <assigment>
         {
             return std::move(assigment());
         }
 
-        if (auto t= scanner.currentMath<LexToken::Separator>("{") )
+        if (auto t= tokens.currentMath(LexToken::SeparatorKind::OpenBrace) )
         {
-            scanner.next();
-            std::vector<AstNode::OwnedNode> statements;
-            while (scanner.current() && !scanner.currentMath<LexToken::Separator>("}"))
+            tokens.next();
+            std::vector<AstNode::NodePtr> statements;
+            while (tokens.current() && !tokens.currentMath(LexToken::SeparatorKind::CloseBrace))
             {
                 statements.push_back(std::move(stmt()));
             }
-            if (scanner.currentMath<LexToken::Separator>("}") )
+            if (tokens.currentMath(LexToken::SeparatorKind::CloseBrace) )
             {
-                scanner.next();
-                return std::make_unique<AstNode::Block>(std::move(statements));
+                tokens.next();
+                return arena.make<AstNode::Block>(arena.makeList(statements));
             }
-            std::cout << "\nCRITICAL INTERPRETER ERROR: expected closing parentheses, opened " << LexToken::printHint(*t) << " not found closing '}'" << std::endl;
+            diagnostics() << "\nCRITICAL INTERPRETER ERROR: expected closing parentheses, opened " << LexToken::printHint(*t) << " not found closing '}'" << std::endl;
             throw std::runtime_error("");
         }
 
-        std::cout << "\nCRITICAL PARSER ERROR: couldn't parse as stmt " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "'in the end of file'") << " unexpected token" << std::endl;
+        diagnostics() << "\nCRITICAL PARSER ERROR: couldn't parse as stmt " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "'in the end of file'") << " unexpected token" << std::endl;
         throw std::runtime_error("");
     }
 
     //<param> ::= <identifier>
-    AstNode::OwnedNode param()
+    AstNode::NodePtr param()
     {
         return std::move(identifier());
     }
     //<function> ::= 'fn' '(' <param>? (',' <param>)* ) <stmt>
-    AstNode::OwnedNode function()
+    AstNode::NodePtr function()
     {
-        auto oP = scanner.currentMath<LexToken::Separator>("fn");
+        auto oP = tokens.currentMath(LexToken::SeparatorKind::Fn);
         if (!oP)
         {
-            std::cout << "\nCRITICAL PARSER ERROR: expected 'fn' as begining of function declaration " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+            diagnostics() << "\nCRITICAL PARSER ERROR: expected 'fn' as begining of function declaration " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
             throw std::runtime_error("");
         }
-        scanner.next();
+        tokens.next();
 
-        std::vector<AstNode::OwnedNode> params;
-        if (auto el = scanner.currentMath<LexToken::Separator>("(") ; !el )
+        std::vector<AstNode::NodePtr> params;
+        if (auto el = tokens.currentMath(LexToken::SeparatorKind::OpenParen) ; !el )
         {
-            std::cout << "\nCRITICAL PARSER ERROR: expected '(' after function declaration " << (scanner.current() ? LexToken::printHint(*scanner.current()) : "end of file") << std::endl;
+            diagnostics() << "\nCRITICAL PARSER ERROR: expected '(' after function declaration " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
             throw std::runtime_error("");
         }
-        scanner.next();
+        tokens.next();
 
-        if (auto el = scanner.currentMath<LexToken::Separator>(")"))
+        if (auto el = tokens.currentMath(LexToken::SeparatorKind::CloseParen))
         {
-            scanner.next();
+            tokens.next();
         }
         else
         {
             params.push_back(std::move(param()));
-            while (scanner.currentMath<LexToken::Separator>(",") )
+            while (tokens.currentMath(LexToken::SeparatorKind::Comma) )
             {
-                scanner.next();
+                tokens.next();
 
                 params.push_back(std::move(param()));
             }
 
-            if (auto el = scanner.currentMath<LexToken::Separator>(")") ; !el )
+            if (auto el = tokens.currentMath(LexToken::SeparatorKind::CloseParen) ; !el )
             {
-                std::cout << "\nCRITICAL PARSER ERROR: mising ')' in function declaration " << LexToken::printHint(*oP) << "opened here" << std::endl;
+                diagnostics() << "\nCRITICAL PARSER ERROR: mising ')' in function declaration " << LexToken::printHint(*oP) << "opened here" << std::endl;
                 throw std::runtime_error("");
             }
-            scanner.next();
+            tokens.next();
         }
         auto st = std::move(stmt());
 
-        return std::make_unique<AstNode::FunctionDecl>(*oP,std::move(params),std::move(st));
+        return arena.make<AstNode::FunctionDecl>(*oP,arena.makeList(params),std::move(st));
+    }
+
+    //<pfor> ::= 'pfor' '(' <label> ':=' <expr> ',' <expr> (',' ('+'|'*'|'&&'|'||'))? ')' <stmt>
+    AstNode::NodePtr parallelFor()
+    {
+        const auto t = *tokens.currentMath(LexToken::Keyword::Pfor);
+        tokens.next();
+
+        auto expect = [this](LexToken::SeparatorKind kind, const char* what)
+        {
+            if (!tokens.currentMath(kind))
+            {
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected " << what << " in pfor statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
+                throw std::runtime_error("");
+            }
+            tokens.next();
+        };
+
+        expect(LexToken::SeparatorKind::OpenParen, "'('");
+        const auto label = tokens.current<LexToken::Label>();
+        if (!label || label->keyword != LexToken::Keyword::None)
+        {
+            diagnostics() << "\nCRITICAL PARSER ERROR: expected index variable in pfor statement " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
+            throw std::runtime_error("");
+        }
+        tokens.next();
+        auto index = arena.make<AstNode::Identifier>(*label);
+
+        expect(LexToken::SeparatorKind::ColonEqual, "':='");
+        auto begin = std::move(expr());
+        expect(LexToken::SeparatorKind::Comma, "','");
+        auto end = std::move(expr());
+
+        std::optional<LexToken::Separator> reduce;
+        if (tokens.currentMath(LexToken::SeparatorKind::Comma))
+        {
+            tokens.next();
+            reduce = tokens.current<LexToken::Separator>();
+            if (!reduce || (reduce->kind != LexToken::SeparatorKind::Plus && reduce->kind != LexToken::SeparatorKind::Star
+                && reduce->kind != LexToken::SeparatorKind::AndAnd && reduce->kind != LexToken::SeparatorKind::OrOr))
+            {
+                diagnostics() << "\nCRITICAL PARSER ERROR: expected '+', '*', '&&' or '||' as pfor reduction " << (tokens.current() ? LexToken::printHint(*tokens.current()) : "end of file") << std::endl;
+                throw std::runtime_error("");
+            }
+            tokens.next();
+        }
+        expect(LexToken::SeparatorKind::CloseParen, "')'");
+
+        auto body = std::move(stmt());
+        return arena.make<AstNode::ParallelFor>(t,std::move(index),std::move(begin),std::move(end),std::move(reduce),std::move(body));
+    }
+
+    //<array> ::= '[' ( <expr> (',' <expr>)* )? ']'
+    AstNode::NodePtr array()
+    {
+        const auto open = *tokens.currentMath(LexToken::SeparatorKind::OpenBracket);
+        tokens.next();
+
+        std::vector<AstNode::NodePtr> elements;
+        if(!tokens.currentMath(LexToken::SeparatorKind::CloseBracket))
+        {
+            elements.push_back(std::move(expr()));
+            while(tokens.currentMath(LexToken::SeparatorKind::Comma))
+            {
+                tokens.next();
+                elements.push_back(std::move(expr()));
+            }
+        }
+        if(!tokens.currentMath(LexToken::SeparatorKind::CloseBracket))
+        {
+            diagnostics() << "\nCRITICAL PARSER ERROR: expected closing bracket, opened " << LexToken::printHint(open) << " not found closing ']'" << std::endl;
+            throw std::runtime_error("");
+        }
+        tokens.next();
+        return arena.make<AstNode::ArrayLiteral>(open,arena.makeList(elements));
+    }
+
+    //<builtin> ::= ('len'|'sum'|'min'|'max'|'dot'|'range'|'fill') '(' <expr> (',' <expr>)* ')'
+    // names of builtins are not reserved, not followed by '(' they are parsed as identifiers
+    AstNode::NodePtr builtin()
+    {
+        const auto name = *tokens.current<LexToken::Label>();
+        tokens.next(); // name
+        tokens.next(); // '('
+
+        std::vector<AstNode::NodePtr> args;
+        args.push_back(std::move(expr()));
+        while(tokens.currentMath(LexToken::SeparatorKind::Comma))
+        {
+            tokens.next();
+            args.push_back(std::move(expr()));
+        }
+        if(!tokens.currentMath(LexToken::SeparatorKind::CloseParen))
+        {
+            diagnostics() << "\nCRITICAL PARSER ERROR: mising ')' in call of builtin function " << LexToken::printHint(name) << "called here" << std::endl;
+            throw std::runtime_error("");
+        }
+        tokens.next();
+
+        if(args.size() != TemporaryValue::builtinArity(*TemporaryValue::toBuiltin(name.content)))
+        {
+            diagnostics() << "\nCRITICAL PARSER ERROR: builtin function '" << name.content << "' takes " << TemporaryValue::builtinArity(*TemporaryValue::toBuiltin(name.content)) << " arguments " << LexToken::printHint(name) << "called here" << std::endl;
+            throw std::runtime_error("");
+        }
+        return arena.make<AstNode::BuiltinCall>(name,arena.makeList(args));
     }
 
     //<block> ::= <stmt>*
-    AstNode::OwnedNode block()
+    AstNode::NodePtr block()
     {
-        std::vector<AstNode::OwnedNode> statements;
+        std::vector<AstNode::NodePtr> statements;
 
-        while (scanner.current() && !scanner.currentMath<LexToken::Separator>("}"))
+        while (tokens.current() && !tokens.currentMath(LexToken::SeparatorKind::CloseBrace))
         {
             statements.push_back(std::move(stmt()));
         }
 
-        return std::make_unique<AstNode::Block>(std::move(statements));
+        return arena.make<AstNode::Block>(arena.makeList(statements));
     }
 
 protected:
-    LexScanner& scanner;
+    LexTokenBuffer& tokens;
+    AstNode::Arena& arena;
 };
\ No newline at end of file
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AstNode.hpp"
+#include "Diagnostics.hpp"
+#include "TemporaryValue.hpp"
+
+// Binds every Identifier to (depth, slot) pair so the interpreters can index RuntimeScope::slots directly.
+//
+// Scopes mirror the ones created at runtime: non-prevented Block, both IfStmt branches, WhileStmt, ForStmt, ParallelFor iteration
+// and function body (parented directly to global scope). Scope declaring nothing gets scopeSize 0 and is elided:
+// it does not count into depth and interpreters run its nodes in the enclosing scope. All names assigned directly in a scope are declared
+// when the scope opens, so a read before the first assignment (e.g. in the next loop iteration) finds its slot.
+// An assignment binds to the nearest scope declaring the name, reads of never assigned names get a global slot.
+// Nested scopes and function bodies see a name of an enclosing scope only once its first assignment precedes them in source,
+// as at runtime a block assigning 'k' before the enclosing scope does gets its own 'k'.
+// ParallelFor body only reads enclosing scopes, every name it assigns is declared in the scope of its iteration.
+// Global names are kept between resolve() calls, which lets the repl keep one global scope across inputs.
+class AstResolver
+{
+public:
+    // resolves root the same way as treeWallInterpret(root,globalScope,globalScope,preventNewScopeFromBlock = true)
+    void resolve(AstNode::NodePtr root)
+    {
+        scopes = {&globals};
+        writableFrom = 0;
+        insideParallel = false;
+        declareAll(root, true, globals);
+        resolveNode(root, true);
+    }
+
+    size_t globalCount() const { return globals.size(); }
+
+    // slot of a global name, nullopt when no resolved code refers to it
+    std::optional<uint32_t> globalSlot(std::string_view name) const
+    {
+        if(auto it = globals.find(name); it != globals.end())
+            return it->second.slot;
+        return std::nullopt;
+    }
+
+protected:
+    struct Declared
+    {
+        uint32_t slot;
+        bool reached;   // assigned by already resolved code (or a global only read, an input), nested scopes resolved from now on see it
+    };
+    using ScopeNames = std::map<std::string, Declared, std::less<>>;
+
+    static uint32_t declare(std::string_view name, ScopeNames& scope, bool reached)
+    {
+        if(auto it = scope.find(name); it != scope.end())
+        {
+            it->second.reached |= reached;
+            return it->second.slot;
+        }
+
+        const auto slot = static_cast<uint32_t>(scope.size());
+        scope.emplace(name, Declared{.slot = slot, .reached = reached});
+        return slot;
+    }
+
+    // visible to assignments, which do not reach below writableFrom
+    bool isVisible(std::string_view name) const
+    {
+        for(size_t i = writableFrom; i < scopes.size(); i++)
+        {
+            if(auto it = scopes[i]->find(name); it != scopes[i]->end() && it->second.reached)
+                return true;
+        }
+        return false;
+    }
+
+    // collects assignments executed directly in scope, without crossing into nested scopes,
+    // names visible from enclosing scopes are assigned there, same as at runtime
+    void declareAll(AstNode::NodePtr in, bool preventNewScopeFromBlock, ScopeNames& scope) const
+    {
+        if(auto asAssign = dynamic_cast<const AstNode::AssignStmt*>(in))
+        {
+            if(auto asId = dynamic_cast<const AstNode::Identifier*>(asAssign->identifier); asId && !isVisible(asId->tokenValue.content))
+                declare(asId->tokenValue.content, scope, false);
+            return;
+        }
+        if(auto asBlock = dynamic_cast<const AstNode::Block*>(in); asBlock && preventNewScopeFromBlock)
+        {
+            for(auto& it : asBlock->statements)
+                declareAll(it, false, scope);
+        }
+    }
+
+    void bind(const AstNode::Identifier& id, bool isAssignment)
+    {
+        const auto& name = id.tokenValue.content;
+        const size_t searched = isAssignment ? scopes.size() - writableFrom : scopes.size();
+        for(size_t depth = 0; depth != searched; depth++)
+        {
+            auto& scope = *scopes[scopes.size()-1-depth];
+            if(auto it = scope.find(name); it != scope.end())
+            {
+                id.depth = static_cast<uint16_t>(depth);
+                id.slot = it->second.slot;
+                it->second.reached |= isAssignment;
+                return;
+            }
+        }
+
+        if(isAssignment) // declareAll always declares assignment targets
+        {
+            diagnostics() << "\nCRITICAL RESOLVER ERROR: undeclared assignment to '" << name << "' " << id.tokenValue.source.printHint() << "here" << std::endl;
+            throw std::runtime_error("");
+        }
+
+        id.depth = static_cast<uint16_t>(scopes.size()-1);
+        id.slot = declare(name, globals, true);
+    }
+
+    // opens new scope executing nodes of in, returns number of slots the scope needs, 0 when it is elided
+    uint32_t resolveScoped(const std::vector<AstNode::NodePtr>& in, bool preventNewScopeFromBlock)
+    {
+        ScopeNames scope;
+        for(auto node : in)
+            declareAll(node, preventNewScopeFromBlock, scope);
+
+        // names are declared only above, so empty scope stays empty
+        if(!scope.empty())
+            scopes.push_back(&scope);
+        for(auto node : in)
+            resolveNode(node, preventNewScopeFromBlock);
+        if(!scope.empty())
+            scopes.pop_back();
+
+        return static_cast<uint32_t>(scope.size());
+    }
+
+    // scope of ParallelFor holds its index and every name assigned by the body, enclosing scopes become read only
+    uint32_t resolveParallel(const AstNode::ParallelFor& in)
+    {
+        ScopeNames scope;
+        if(auto asId = dynamic_cast<const AstNode::Identifier*>(in.index))
+        {
+            asId->depth = 0;
+            asId->slot = declare(asId->tokenValue.content, scope, true);
+        }
+
+        const auto outerWritableFrom = std::exchange(writableFrom, scopes.size());
+        const auto outerParallel = std::exchange(insideParallel, true);
+        scopes.push_back(&scope);
+
+        declareAll(in.body, true, scope);
+        resolveNode(in.body, true);
+
+        scopes.pop_back();
+        writableFrom = outerWritableFrom;
+        insideParallel = outerParallel;
+
+        return static_cast<uint32_t>(scope.size());
+    }
+
+    void resolveNode(AstNode::NodePtr in, bool preventNewScopeFromBlock = false);
+
+    struct ResolverVisitor;
+
+    ScopeNames globals {};
+    std::vector<ScopeNames*> scopes {};
+    size_t writableFrom {0};        // index of the outermost scope assignments may bind to
+    bool insideParallel {false};    // resolving ParallelFor body, outside of functions declared in it
+};
+
+struct AstResolver::ResolverVisitor : public AstNode::IVisitor
+{
+    AstResolver& resolver;
+    bool preventNewScopeFromBlock;
+
+    ResolverVisitor(AstResolver& resolver, bool prevent_new_scope_from_block)
+        : resolver(resolver),
+          preventNewScopeFromBlock(prevent_new_scope_from_block)
+    {
+    }
+
+    void operator()(const AstNode::Identifier& v) override { resolver.bind(v, false); }
+    void operator()(const AstNode::Integer&) override {}
+    void operator()(const AstNode::Float&) override {}
+    void operator()(const AstNode::String&) override {}
+    void operator()(const AstNode::Bool&) override {}
+    void operator()(const AstNode::UnaryOp& v) override
+    {
+        resolver.resolveNode(v.inner);
+    }
+    void operator()(const AstNode::BinaryOp& v) override
+    {
+        resolver.resolveNode(v.left);
+        resolver.resolveNode(v.right);
+    }
+    void operator()(const AstNode::ArrayLiteral& v) override
+    {
+        for(auto& it : v.elements)
+            resolver.resolveNode(it);
+    }
+    void operator()(const AstNode::Index& v) override
+    {
+        resolver.resolveNode(v.target);
+        resolver.resolveNode(v.index);
+    }
+    void operator()(const AstNode::BuiltinCall& v) override
+    {
+        for(auto& it : v.args)
+            resolver.resolveNode(it);
+    }
+    void operator()(const AstNode::Block& v) override
+    {
+        if(preventNewScopeFromBlock)
+        {
+            for(auto& it : v.statements)
+                resolver.resolveNode(it);
+            return;
+        }
+
+        v.scopeSize = resolver.resolveScoped(std::vector<AstNode::NodePtr>(v.statements.begin(), v.statements.end()), false);
+    }
+    void operator()(const AstNode::PrintStmt& v) override
+    {
+        resolver.resolveNode(v.inner);
+    }
+    void operator()(const AstNode::IfStmt& v) override
+    {
+        resolver.resolveNode(v.when);
+        v.thenScopeSize = resolver.resolveScoped({v.then}, true);
+        if(v.elseThen)
+            v.elseScopeSize = resolver.resolveScoped({v.elseThen}, true);
+    }
+    void operator()(const AstNode::AssignStmt& v) override
+    {
+        // target first, a function declared by the value runs only after the assignment, so its body sees the name
+        if(auto asId = dynamic_cast<const AstNode::Identifier*>(v.identifier))
+            resolver.bind(*asId, true);
+        resolver.resolveNode(v.value);
+    }
+    void operator()(const AstNode::WhileStmt& v) override
+    {
+        v.scopeSize = resolver.resolveScoped({v.until, v.loop}, true);
+    }
+    void operator()(const AstNode::ForStmt& v) override
+    {
+        v.scopeSize = resolver.resolveScoped({v.doOnce, v.until, v.loop, v.afterIter}, true);
+    }
+    void operator()(const AstNode::ParallelFor& v) override
+    {
+        resolver.resolveNode(v.begin);
+        resolver.resolveNode(v.end);
+        v.scopeSize = resolver.resolveParallel(v);
+    }
+    void operator()(const AstNode::FunctionDecl& v) override
+    {
+        // function body sees only its own scope and global scope
+        auto outerScopes = std::move(resolver.scopes);
+        resolver.scopes = {&resolver.globals};
+        const auto outerWritableFrom = std::exchange(resolver.writableFrom, 0);
+        const auto outerParallel = std::exchange(resolver.insideParallel, false);
+
+        ScopeNames scope;
+        for(auto& it : v.params)
+        {
+            if(auto asId = dynamic_cast<const AstNode::Identifier*>(it))
+            {
+                asId->depth = 0;
+                asId->slot = declare(asId->tokenValue.content, scope, true);
+            }
+        }
+        resolver.declareAll(v.body, true, scope);
+
+        resolver.scopes = {&resolver.globals, &scope};
+        resolver.resolveNode(v.body, true);
+        resolver.scopes = std::move(outerScopes);
+        resolver.writableFrom = outerWritableFrom;
+        resolver.insideParallel = outerParallel;
+
+        v.scopeSize = static_cast<uint32_t>(scope.size());
+
+        // body is copied once resolved, nested declarations first, so running the tree never creates it
+        TemporaryValue::FuncBody::of(v);
+    }
+    void operator()(const AstNode::FunctionCall& v) override
+    {
+        resolver.resolveNode(v.name);
+        for(auto& it : v.args)
+            resolver.resolveNode(it);
+    }
+    void operator()(const AstNode::Return& v) override
+    {
+        if(resolver.insideParallel)
+        {
+            diagnostics() << "\nCRITICAL RESOLVER ERROR: 'ret' can't leave pfor body " << v.tokenValue.source.printHint() << "here" << std::endl;
+            throw std::runtime_error("");
+        }
+        resolver.resolveNode(v.inner);
+    }
+};
+
+inline void AstResolver::resolveNode(AstNode::NodePtr in, bool preventNewScopeFromBlock)
+{
+    in->accept(ResolverVisitor(*this, preventNewScopeFromBlock));
+}
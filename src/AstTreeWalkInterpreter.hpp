@@ -1,40 +1,36 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cmath>
-#include <regex>
 #include <sstream>
 
 #include "AstNode.hpp"
+#include "Diagnostics.hpp"
+#include "ParallelFor.hpp"
 #include "RuntimeScope.hpp"
 #include "TemporaryValue.hpp"
 
-const int MAX_LOOP_ITERATION = 1000;
-
 template <typename T>
 concept hasTokenValue = requires(T t)
 {
     {t.tokenValue} -> std::convertible_to<LexToken::Any>;
 };
 
-struct FuncReturn
-{
-    TemporaryValue::Any result;
-};
-
-TemporaryValue::Any treeWallInterpret(const AstNode::OwnedNode& in,RuntimeScope& globalScope,RuntimeScope& localScope,bool preventNewScopeFromBlock = false);
+inline TemporaryValue::Any treeWallInterpret(AstNode::NodePtr in,RuntimeContext& context,RuntimeScope& localScope,bool preventNewScopeFromBlock = false);
 struct InterpreterVisitor : public AstNode::IVisitor
 {
 
     TemporaryValue::Any& result;
-    RuntimeScope& globalScope;
+    RuntimeContext& context;
     RuntimeScope& localScope;
     bool preventNewScopeFromBlock;
 
 
-    InterpreterVisitor(TemporaryValue::Any& result, RuntimeScope& global_scope, RuntimeScope& local_scope,
+    InterpreterVisitor(TemporaryValue::Any& result, RuntimeContext& context, RuntimeScope& local_scope,
         bool prevent_new_scope_from_block)
         : result(result),
-          globalScope(global_scope),
+          context(context),
           localScope(local_scope),
           preventNewScopeFromBlock(prevent_new_scope_from_block)
     {
@@ -42,7 +38,7 @@ struct InterpreterVisitor : public AstNode::IVisitor
 
     void operator()(const AstNode::Identifier& v) override
     {
-        auto e = localScope.getVariable(v.tokenValue.content);
+        auto e = localScope.getVariable(v.depth, v.slot);
         if(e) result = TemporaryValue::Any{*e};
     }
 
@@ -56,367 +52,374 @@ struct InterpreterVisitor : public AstNode::IVisitor
     }
     void operator()(const AstNode::String& v) override
     {
-        result = TemporaryValue::String{v.tokenValue.content};
+        result = TemporaryValue::String{std::string(v.value)};
     }
 
     void operator()(const AstNode::Bool& v) override
     {
-        result = TemporaryValue::Bool{v.tokenValue.content == "true"};
+        result = TemporaryValue::Bool{v.tokenValue.keyword == LexToken::Keyword::True};
     }
     void operator()(const AstNode::UnaryOp& v) override
     {
-        if(v.tokenValue.content == "-")
-        {
-            auto inner = treeWallInterpret(v.inner,globalScope,localScope);
-
-            if (inner |vx::is<TemporaryValue::Float>)
-            {
-                result = TemporaryValue::Float{-(inner|vx::as<TemporaryValue::Float>).value };
-            }
-            else if (inner |vx::is<TemporaryValue::Integer>)
-            {
-                result = TemporaryValue::Integer{-(inner|vx::as<TemporaryValue::Integer>).value };
-            }
-        }
-
-        if(v.tokenValue.content == "+")
-        {
-            auto inner = treeWallInterpret(v.inner,globalScope,localScope);
-
-            if (inner |vx::is<TemporaryValue::Float>)
-            {
-                result = TemporaryValue::Float{(inner|vx::as<TemporaryValue::Float>).value };
-            }
-            else if (inner |vx::is<TemporaryValue::Integer>)
-            {
-                result = TemporaryValue::Integer{(inner|vx::as<TemporaryValue::Integer>).value };
-            }
-        }
-
-        if(v.tokenValue.content == "!")
+        if(auto op = TemporaryValue::toUnaryOperator(v.tokenValue.kind))
         {
-            auto inner = treeWallInterpret(v.inner,globalScope,localScope);
-
-            if (inner |vx::is<TemporaryValue::Bool>)
-            {
-                result = TemporaryValue::Bool{!(inner|vx::as<TemporaryValue::Bool>).value };
-            }
+            auto inner = treeWallInterpret(v.inner,context,localScope);
+            result = TemporaryValue::unaryOp(*op, inner);
         }
     }
     void operator()(const AstNode::BinaryOp& v) override
     {
-       auto left = treeWallInterpret(v.left,globalScope,localScope);
+       auto left = treeWallInterpret(v.left,context,localScope);
 
         if(left |vx::is<TemporaryValue::Bool>)
         {
-            if(v.tokenValue.content == "&&")
+            switch(v.tokenValue.kind)
             {
-                if(TemporaryValue::getBool(left) == false)
+                case LexToken::SeparatorKind::AndAnd:
                 {
-                    result = TemporaryValue::Bool{false};
+                    if(TemporaryValue::getBool(left) == false)
+                    {
+                        result = TemporaryValue::Bool{false};
+                        return;
+                    }
+
+                    auto right = treeWallInterpret(v.right,context,localScope);
+                    result = TemporaryValue::Bool{TemporaryValue::getBool(right)};
                     return;
                 }
-
-                auto right = treeWallInterpret(v.right,globalScope,localScope);
-                result = TemporaryValue::Bool{TemporaryValue::getBool(right)};
-                return;
+                case LexToken::SeparatorKind::OrOr:
+                {
+                    if(TemporaryValue::getBool(left) == true)
+                    {
+                        result = TemporaryValue::Bool{true};
+                        return;
+                    }
+
+                    auto right = treeWallInterpret(v.right,context,localScope);
+                    result = TemporaryValue::Bool{TemporaryValue::getBool(right)};
+                    return;
+                }
+                default:
+                    break;
             }
-            if(v.tokenValue.content == "||")
+        }
+
+        auto right = treeWallInterpret(v.right,context,localScope);
+
+        if(auto op = TemporaryValue::toBinaryOperator(v.tokenValue.kind))
+        {
+            try
             {
-                if(TemporaryValue::getBool(left) == true)
+                // relaxed atomic, threads running one tree may record the site concurrently
+                std::atomic_ref quickened(v.quickened);
+                auto types = quickened.load(std::memory_order_relaxed);
+                if(types == TemporaryValue::OperandTypes::Unknown)
                 {
-                    result = TemporaryValue::Bool{true};
-                    return;
+                    types = TemporaryValue::operandTypes(left, right);
+                    quickened.store(types, std::memory_order_relaxed);
                 }
 
-                auto right = treeWallInterpret(v.right,globalScope,localScope);
-                result = TemporaryValue::Bool{TemporaryValue::getBool(right)};
-                return;
-            }
+                if(types != TemporaryValue::OperandTypes::Mixed)
+                {
+                    if(auto value = TemporaryValue::quickBinaryOp(*op, types, left, right))
+                    {
+                        result = std::move(*value);
+                        return;
+                    }
+                    quickened.store(TemporaryValue::OperandTypes::Mixed, std::memory_order_relaxed); // guard failed, site stays generic
+                }
 
-            auto right = treeWallInterpret(v.right,globalScope,localScope);
-            if(v.tokenValue.content == "==")
-                result = TemporaryValue::Bool{TemporaryValue::getBool(left) == TemporaryValue::getBool(right)};
-            if(v.tokenValue.content == "!=")
-                result = TemporaryValue::Bool{TemporaryValue::getBool(left) != TemporaryValue::getBool(right)};
-            return;
+                if(auto value = TemporaryValue::binaryOp(*op, left, right))
+                {
+                    result = std::move(*value);
+                    return;
+                }
+            }
+            catch(TemporaryValue::ArithmeticError&)
+            {
+                diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+                throw std::runtime_error("");
+            }
         }
 
-        auto right = treeWallInterpret(v.right,globalScope,localScope);
+        diagnostics() << "unsupported operation:'" << v.tokenValue.content << "' between left:'" << left << "' and right:'" << right << "'\n";
+        diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+        diagnostics() << "left: " << AstNode::stringify(*v.left) << '\n';
+        diagnostics() << "right: " << AstNode::stringify(*v.right) << '\n';
+        throw std::runtime_error("");
+
+    }
+    void operator()(const AstNode::ArrayLiteral& v) override
+    {
+        std::vector<TemporaryValue::Any> elements(v.elements.size());
+        for(size_t i = 0; i != v.elements.size(); i++)
+            elements[i] = treeWallInterpret(v.elements[i],context,localScope);
 
-        if(left |vx::is<TemporaryValue::Integer> && right |vx::is<TemporaryValue::Integer>)
+        if(auto value = TemporaryValue::makeArray(elements.data(), elements.size()))
         {
-            if(v.tokenValue.content == "==")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) == TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "!=")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) != TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "<")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) < TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == ">")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) > TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "<=")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) <= TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == ">=")
-                {result = TemporaryValue::Bool{TemporaryValue::getInteger(left) >= TemporaryValue::getInteger(right)};return;}
-
-            if(v.tokenValue.content == "+")
-                {result = TemporaryValue::Integer{TemporaryValue::getInteger(left) + TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "-")
-                {result = TemporaryValue::Integer{TemporaryValue::getInteger(left) - TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "*")
-                {result = TemporaryValue::Integer{TemporaryValue::getInteger(left) * TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "/")
-                {result = TemporaryValue::Integer{TemporaryValue::getInteger(left) / TemporaryValue::getInteger(right)};return;}
-            if(v.tokenValue.content == "%")
-                {result = TemporaryValue::Integer{TemporaryValue::getInteger(left) % TemporaryValue::getInteger(right)};return;}
-
-            if(v.tokenValue.content == "^")
-                {result = TemporaryValue::Integer{static_cast<int>(
-                    std::pow(TemporaryValue::getInteger(left),TemporaryValue::getInteger(right))
-                )};return;}
+            result = std::move(*value);
+            return;
         }
+        diagnostics() << "array elements must be numbers\n";
+        diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+        throw std::runtime_error("");
+    }
+    void operator()(const AstNode::Index& v) override
+    {
+        auto target = treeWallInterpret(v.target,context,localScope);
+        auto index = treeWallInterpret(v.index,context,localScope);
 
-        if((left |vx::is<TemporaryValue::Integer> || left |vx::is<TemporaryValue::Float>) && (right |vx::is<TemporaryValue::Integer> || right |vx::is<TemporaryValue::Float>)) // If any argument is float, promote to float
+        if(auto value = TemporaryValue::indexArray(target, index))
         {
-            if(v.tokenValue.content == "==")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) == TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "!=")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) != TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "<")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) < TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == ">")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) > TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "<=")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) <= TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == ">=")
-                {result = TemporaryValue::Bool{TemporaryValue::getFloat(left) >= TemporaryValue::getFloat(right)};return;}
-
-
-            if(v.tokenValue.content == "+")
-                {result = TemporaryValue::Float{TemporaryValue::getFloat(left) + TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "-")
-                {result = TemporaryValue::Float{TemporaryValue::getFloat(left) - TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "*")
-                {result = TemporaryValue::Float{TemporaryValue::getFloat(left) * TemporaryValue::getFloat(right)};return;}
-            if(v.tokenValue.content == "/")
-                {result = TemporaryValue::Float{TemporaryValue::getFloat(left) / TemporaryValue::getFloat(right)};return;}
-
-            if(v.tokenValue.content == "^")
-                {result = TemporaryValue::Float{std::pow(TemporaryValue::getFloat(left),TemporaryValue::getFloat(right))};return;}
+            result = std::move(*value);
+            return;
         }
-        if((left |vx::is<TemporaryValue::String> || right |vx::is<TemporaryValue::String>) )
-        {
-            if(v.tokenValue.content == "==")
-                {result = TemporaryValue::Bool{TemporaryValue::getString(left) == TemporaryValue::getString(right)};return;}
-            if(v.tokenValue.content == "!=")
-                {result = TemporaryValue::Bool{TemporaryValue::getString(left) != TemporaryValue::getString(right)};return;}
+        diagnostics() << "unsupported index:'" << index << "' of:'" << target << "'\n";
+        diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+        throw std::runtime_error("");
+    }
+    void operator()(const AstNode::BuiltinCall& v) override
+    {
+        std::array<TemporaryValue::Any, TemporaryValue::MAX_BUILTIN_ARITY> args;
+        for(size_t i = 0; i != v.args.size(); i++)
+            args[i] = treeWallInterpret(v.args[i],context,localScope);
 
-            if(v.tokenValue.content == "+")
-                {result = TemporaryValue::String{TemporaryValue::getString(left) + TemporaryValue::getString(right)};return;}
+        if(auto value = TemporaryValue::callBuiltin(*TemporaryValue::toBuiltin(v.tokenValue.content), args.data()))
+        {
+            result = std::move(*value);
+            return;
         }
-
-        std::cout << "unsupported operation:'" << v.tokenValue.content << "' between left:'" << left << "' and right:'" << right << "'\n";
-        std::cout << v.tokenValue.source.printHint()  << "here \n";
-        std::cout << "left: " << AstNode::stringify(*v.left) << '\n';
-        std::cout << "right: " << AstNode::stringify(*v.right) << '\n';
+        diagnostics() << "unsupported arguments of builtin function:";
+        for(size_t i = 0; i != v.args.size(); i++)
+            diagnostics() << " '" << args[i] << "'";
+        diagnostics() << "\n";
+        diagnostics() << v.tokenValue.source.printHint()  << "here \n";
         throw std::runtime_error("");
-
     }
     void operator()(const AstNode::Block& v) override
     {
         if(preventNewScopeFromBlock)
         {
-            if(v.statements.size() >= 1)
-            {
-                for(int i = 0; i != v.statements.size()-1; i++)
-                {
-                    treeWallInterpret(v.statements[i],globalScope,localScope);
-                }
-                result =  treeWallInterpret(v.statements[v.statements.size()-1],globalScope,localScope);
-                return;
-            }
+            runStatements(v.statements, localScope);
         }
         else
         {
-            auto blockScope = RuntimeScope(localScope);
-            if(v.statements.size() >= 1)
-            {
-                for(int i = 0; i != v.statements.size()-1; i++)
-                {
-                    treeWallInterpret(v.statements[i],globalScope,blockScope);
-                }
-                result = treeWallInterpret(v.statements[v.statements.size()-1],globalScope,blockScope);
+            auto& blockScope = openScope(v.scopeSize);
+            runStatements(v.statements, blockScope);
+            closeScope(v.scopeSize);
+        }
+    }
+    // scope declaring nothing is elided by AstResolver, its nodes run in localScope
+    RuntimeScope& openScope(uint32_t size)
+    {
+        return size == 0 ? localScope : context.pushScope(localScope, size);
+    }
+    void closeScope(uint32_t size)
+    {
+        if(size != 0)
+            context.popScope();
+    }
+    // result of the last executed statement, stops early after 'ret'
+    void runStatements(AstNode::NodeList statements, RuntimeScope& scope)
+    {
+        for(auto& it : statements)
+        {
+            result = treeWallInterpret(it,context,scope);
+            if(!context.completedNormally())
                 return;
-            }
         }
     }
     void operator()(const AstNode::PrintStmt& v) override
     {
-        result = treeWallInterpret(v.inner,globalScope,localScope);
-        result |vx::match {
-            [](const TemporaryValue::Bool& v)       { std::cout << (v.value ? "true" : "false") ;},
-            [](const TemporaryValue::Integer& v)    { std::cout <<  v.value;},
-            [](const TemporaryValue::Float& v)      { std::cout <<  v.value;},
-            [](const TemporaryValue::String& v)
-            {
-                std::cout <<  std::regex_replace(v.value, std::regex(R"(\\n)"), "\n");
-            },
-            [](const TemporaryValue::Func& v)
-            {
-                std::cout << "<func>";
-            }
-        };
-        return;
+        result = treeWallInterpret(v.inner,context,localScope);
+        TemporaryValue::print(context.output, result);
     }
     void operator()(const AstNode::IfStmt& v) override
     {
-        auto when = treeWallInterpret(v.when,globalScope,localScope);
+        auto when = treeWallInterpret(v.when,context,localScope);
 
         if(TemporaryValue::getBool(when))
         {
-            auto blockScope = RuntimeScope(localScope);
-            result = treeWallInterpret(v.then,globalScope,blockScope,true);
+            auto& blockScope = openScope(v.thenScopeSize);
+            result = treeWallInterpret(v.then,context,blockScope,true);
+            closeScope(v.thenScopeSize);
             return;
         }
         if(v.elseThen)
         {
-            auto blockScope = std::make_unique<RuntimeScope>(localScope);
-            result = treeWallInterpret(v.elseThen,globalScope,localScope,true);
+            auto& blockScope = openScope(v.elseScopeSize);
+            result = treeWallInterpret(v.elseThen,context,blockScope,true);
+            closeScope(v.elseScopeSize);
             return;
         }
     }
     void operator()(const AstNode::AssignStmt& v) override
     {
-        auto asId = dynamic_cast<AstNode::Identifier*>(v.identifier.get());
+        auto asId = dynamic_cast<AstNode::Identifier*>(v.identifier);
         if(!asId)
         {
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
-        auto varName = asId->tokenValue.content;
-        auto value = treeWallInterpret(v.value,globalScope,localScope);
+        auto value = treeWallInterpret(v.value,context,localScope);
 
-        if(auto var = localScope.getVariable(varName))
+        auto& scope = localScope.scopeAt(asId->depth);
+        if(context.isSharedScope(scope)) [[unlikely]]
         {
-            if(var->index() == value.index())
-            {
-                *var = std::move(value);
-                result = TemporaryValue::Any{*var};
-                return;
-            }
-
-            std::cout << "forbitted redefintion variable:'" << varName << "' old value:'" << *var << "' new value:'" << value << "'\n";
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << "can't assign global variable:'" << asId->tokenValue.content << "' inside pfor, functions called from its body only read globals\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
-        localScope.variables[varName] = std::move(value);
+        auto& var = scope.slots[asId->slot];
+        if(var && var->index() != value.index())
+        {
+            diagnostics() << "forbitted redefintion variable:'" << asId->tokenValue.content << "' old value:'" << *var << "' new value:'" << value << "'\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+            throw std::runtime_error("");
+        }
+        var = std::move(value);
 
-        result = TemporaryValue::Any{localScope.variables[varName]};
+        result = TemporaryValue::Any{*var};
     }
     void operator()(const AstNode::WhileStmt& v) override
     {
-        auto blockScope = RuntimeScope(localScope);
-
+        auto& blockScope = openScope(v.scopeSize);
+        runWhile(v, blockScope);
+        closeScope(v.scopeSize);
+    }
+    void runWhile(const AstNode::WhileStmt& v, RuntimeScope& blockScope)
+    {
         result = TemporaryValue::Bool{false};
 
-        for(int i = 0; i!= MAX_LOOP_ITERATION; i++) //max iteration
+        while(true)
         {
-            auto until = treeWallInterpret(v.until,globalScope,blockScope);
-            if(TemporaryValue::getBool(until))
-            {
-                result = treeWallInterpret(v.loop,globalScope,blockScope,true);
-                continue;
-            }
-            break;
+            auto until = treeWallInterpret(v.until,context,blockScope);
+            if(!TemporaryValue::getBool(until))
+                break;
+
+            result = treeWallInterpret(v.loop,context,blockScope,true);
+            if(!context.completedNormally())
+                return;
+            consumeFuel(v.tokenValue.source);
         }
     }
+    // at loop back-edge and call, stops the execution once RuntimeBudget is spent
+    void consumeFuel(const LexToken::Source& source)
+    {
+        if(context.consumeFuel()) [[likely]]
+            return;
+        diagnostics() << "budget exhausted: " << context.exhaustedReason() << "\n";
+        diagnostics() << source.printHint()  << "here \n";
+        throw BudgetExhausted();
+    }
     void operator()(const AstNode::ForStmt& v) override
     {
-        auto blockScope = RuntimeScope(localScope);
-
-        treeWallInterpret(v.doOnce,globalScope,blockScope,true);
+        auto& blockScope = openScope(v.scopeSize);
+        runFor(v, blockScope);
+        closeScope(v.scopeSize);
+    }
+    void runFor(const AstNode::ForStmt& v, RuntimeScope& blockScope)
+    {
+        result = treeWallInterpret(v.doOnce,context,blockScope,true);
+        if(!context.completedNormally())
+            return;
 
         result = TemporaryValue::Bool{false};
 
-        for(int i = 0; i!= MAX_LOOP_ITERATION; i++) //max iteration
+        while(true)
         {
-            auto until = treeWallInterpret(v.until,globalScope,blockScope);
-            if(TemporaryValue::getBool(until))
+            auto until = treeWallInterpret(v.until,context,blockScope);
+            if(!TemporaryValue::getBool(until))
+                break;
+
+            result = treeWallInterpret(v.loop,context,blockScope,true);
+            if(!context.completedNormally())
+                return;
+            if(auto after = treeWallInterpret(v.afterIter,context,blockScope,true); !context.completedNormally())
             {
-                result = treeWallInterpret(v.loop,globalScope,blockScope,true);
-                treeWallInterpret(v.afterIter,globalScope,blockScope,true);
-                continue;
+                result = std::move(after);
+                return;
             }
-            break;
+            consumeFuel(v.tokenValue.source);
         }
-
+    }
+    void operator()(const AstNode::ParallelFor& v) override
+    {
+        auto begin = treeWallInterpret(v.begin,context,localScope);
+        auto end = treeWallInterpret(v.end,context,localScope);
+        result = runParallelFor(v, context, localScope, begin, end, [&v](RuntimeContext& worker)
+        {
+            return [&v, &worker](RuntimeScope& scope) { return treeWallInterpret(v.body,worker,scope,true); };
+        });
     }
     void operator()(const AstNode::FunctionDecl& v) override
     {
-        result = TemporaryValue::Func{v.copy()};
+        result = TemporaryValue::Func{v};
     }
     void operator()(const AstNode::FunctionCall& v) override
     {
-        /*
-        auto asId = dynamic_cast<AstNode::Identifier*>(v.name.get());
-        if(!asId)
+        if(context.callDepth() == MAX_CALL_DEPTH)
         {
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << "exceeded max call depth\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
-        if(!localScope.getVariable(asId->tokenValue.content))
+        consumeFuel(v.tokenValue.source);
+
+        // arguments go straight into the pooled frame, nested calls take frames above it
+        auto& frame = context.pushFrame(v.args.size());
+        for(size_t i = 0; i != v.args.size(); ++i)
+            frame.slots[i] = treeWallInterpret(v.args[i],context,localScope);
+
+        auto asId = dynamic_cast<AstNode::Identifier*>(v.name);
+        auto callee = asId ? localScope.getVariable(asId->depth, asId->slot) : nullptr;
+        if(!callee)
         {
-            std::cout << "Undefined function\n";
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << "Undefined function\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
-
-        if(!((*localScope.getVariable(v.name.tokenValue.content))|vx::is<TemporaryValue::Func>))
+        if(!(*callee |vx::is<TemporaryValue::Func>))
         {
-            std::cout << "that is not a function\n";
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << "that is not a function\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
 
-        auto& fn = (*localScope.getVariable(v.name.tokenValue.content))|vx::as<TemporaryValue::Func>;
-
-
-
-        if(fn.value.params.size() != v.params.size())
+        // holding the body keeps it alive even when the body reassigns its own variable
+        const auto body = (*callee |vx::as<TemporaryValue::Func>).value;
+        auto& fn = *body->decl;
+        if(fn.params.size() != v.args.size())
         {
-            std::cout << "not matching number of arguments\n";
-            std::cout << v.tokenValue.source.printHint()  << "here \n";
+            diagnostics() << "not matching number of arguments\n";
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
             throw std::runtime_error("");
         }
-        auto fnScope = std::make_unique<RuntimeScope>(globalScope);
-        for(int i = 0; i!= v.params.size(); ++i)
-        {
-            fnScope->variables[fn.value.params[i].tokenValue.content] = treeWallInterpret(v.params[i],globalScope,localScope);
-        }
 
-        try
+        frame.slots.resize(fn.scopeSize);
+        result = treeWallInterpret(fn.body,context,frame,true);
+        if(context.completion == RuntimeContext::Completion::Return)
         {
-            auto res = treeWallInterpret(*fn.value.body,globalScope,fnScope.get(),true);
-            return std::move(res);
+            result = std::move(context.returnValue);
+            context.completion = RuntimeContext::Completion::Normal;
         }
-        catch(FuncReturn& ret)
-        {
-            return std::move(ret.result);
-        }*/
+        context.popFrame();
     }
     void operator()(const AstNode::Return& v) override
     {
-        throw FuncReturn{treeWallInterpret(v.inner,globalScope,localScope)};
+        result = treeWallInterpret(v.inner,context,localScope);
+        context.completion = RuntimeContext::Completion::Return;
+        context.returnValue = result;
     }
 };
 
 
-TemporaryValue::Any treeWallInterpret(const AstNode::OwnedNode& in,RuntimeScope& globalScope,RuntimeScope& localScope,bool preventNewScopeFromBlock)
+inline TemporaryValue::Any treeWallInterpret(AstNode::NodePtr in,RuntimeContext& context,RuntimeScope& localScope,bool preventNewScopeFromBlock)
 {
     TemporaryValue::Any result;
-    in->accept(InterpreterVisitor(result,globalScope,localScope,preventNewScopeFromBlock));
+    in->accept(InterpreterVisitor(result,context,localScope,preventNewScopeFromBlock));
     return result;
 
-    std::cout << "unable to execute '" << in << "'\n";
+    diagnostics() << "unable to execute '" << in << "'\n";
     throw std::runtime_error("interpreting error");
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "ByteCode.hpp"
+
+#include <ostream>
+
+size_t ByteCode::Chunk::emit(OpCode op, uint32_t operand, const LexToken::Source& source)
+{
+    code.push_back(Instruction{.op = op, .operand = operand});
+    sources.push_back(source);
+    return code.size()-1;
+}
+
+size_t ByteCode::Chunk::emitSlot(OpCode op, uint16_t depth, uint32_t slot, std::string_view name, const LexToken::Source& source)
+{
+    const auto at = emit(op, slot, source);
+    code[at].depth = depth;
+    slotNames[at] = std::string(name);
+    return at;
+}
+
+uint32_t ByteCode::Chunk::addConstant(TemporaryValue::Any value)
+{
+    constants.push_back(std::move(value));
+    return static_cast<uint32_t>(constants.size()-1);
+}
+
+const char* ByteCode::toString(OpCode op)
+{
+    switch(op)
+    {
+        case OpCode::PushConst:     return "PushConst";
+        case OpCode::Pop:           return "Pop";
+        case OpCode::LoadSlot:      return "LoadSlot";
+        case OpCode::StoreSlot:     return "StoreSlot";
+        case OpCode::PushScope:     return "PushScope";
+        case OpCode::PopScope:      return "PopScope";
+        case OpCode::Unary:         return "Unary";
+        case OpCode::Binary:        return "Binary";
+        case OpCode::BinaryIntegers: return "BinaryIntegers";
+        case OpCode::BinaryFloats:  return "BinaryFloats";
+        case OpCode::BinaryGeneric: return "BinaryGeneric";
+        case OpCode::AndJump:       return "AndJump";
+        case OpCode::OrJump:        return "OrJump";
+        case OpCode::ToBool:        return "ToBool";
+        case OpCode::Jump:          return "Jump";
+        case OpCode::JumpIfFalse:   return "JumpIfFalse";
+        case OpCode::Loop:          return "Loop";
+        case OpCode::Print:         return "Print";
+        case OpCode::MakeArray:     return "MakeArray";
+        case OpCode::Index:         return "Index";
+        case OpCode::Builtin:       return "Builtin";
+        case OpCode::ParallelFor:   return "ParallelFor";
+        case OpCode::Call:          return "Call";
+        case OpCode::Return:        return "Return";
+    }
+    return "unknown";
+}
+
+std::string ByteCode::stringify(const Chunk& in)
+{
+    std::string result;
+    for(size_t i = 0; i != in.code.size(); i++)
+    {
+        const auto& instruction = in.code[i];
+        result += std::to_string(i) + "\t" + toString(instruction.opcode()) + " ";
+
+        if(auto it = in.slotNames.find(i); it != in.slotNames.end())
+            result += std::to_string(instruction.depth) + ":" + std::to_string(instruction.operand) + "\t; " + it->second;
+        else
+            result += std::to_string(instruction.operand);
+
+        result += "\n";
+    }
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const ByteCode::Chunk& in)
+{
+    return os << ByteCode::stringify(in);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LexToken.hpp"
+#include "TemporaryValue.hpp"
+
+namespace ByteCode
+{
+    enum class OpCode : uint8_t
+    {
+        PushConst,      // push constants[operand]
+        Pop,            // drop top of the stack
+        LoadSlot,       // push variable (depth, operand), Bool{false} when undefined
+        StoreSlot,      // assign top of the stack to variable (depth, operand), value stays on the stack
+        PushScope,      // open scope with operand slots
+        PopScope,
+        Unary,          // TemporaryValue::UnaryOperator(operand) on top of the stack
+        Binary,         // TemporaryValue::BinaryOperator(operand) on two top values, quickened by the vm on first run
+        BinaryIntegers, // Binary quickened to TemporaryValue::OperandTypes::Integers, falls back to BinaryGeneric when guard fails
+        BinaryFloats,   // Binary quickened to TemporaryValue::OperandTypes::Floats, falls back to BinaryGeneric when guard fails
+        BinaryGeneric,  // Binary at a site which saw mixed types
+        AndJump,        // '&&' short circuit: keep false and jump to operand, otherwise pop
+        OrJump,         // '||' short circuit: keep true and jump to operand, otherwise pop
+        ToBool,         // replace top of the stack with Bool{getBool(top)}
+        Jump,
+        JumpIfFalse,    // pop condition, jump to operand when false
+        Loop,           // loop back-edge, takes one unit of RuntimeContext fuel and jumps to operand
+        Print,          // print top of the stack, value stays on the stack
+        MakeArray,      // replace operand values on top of the stack with TemporaryValue::Array of them
+        Index,          // replace array and index on top of the stack with the element
+        Builtin,        // call TemporaryValue::Builtin(operand) with its arguments on top of the stack, replaces them with the result
+        ParallelFor,    // run Chunk::parallelLoops[operand] over begin and end on top of the stack, replaces them with its value
+        Call,           // call function on top of the stack with operand arguments below it, replaces them all with the result
+        Return,         // return top of the stack from function, or stop the top level chunk
+    };
+
+    struct Instruction
+    {
+        mutable OpCode op; // Binary is rewritten in place by ByteCodeVm quickening, read and written through opcode() and quicken()
+        uint16_t depth {};
+        uint32_t operand {};
+
+        // relaxed atomic access, threads running one chunk may quicken it concurrently and every form of a site is valid
+        OpCode opcode() const { return std::atomic_ref(op).load(std::memory_order_relaxed); }
+        void quicken(OpCode to) const { std::atomic_ref(op).store(to, std::memory_order_relaxed); }
+    };
+
+    struct Chunk;
+
+    // body of a pfor, compiled in the scope of its iteration and run by a ByteCodeVm of every worker
+    struct ParallelLoop
+    {
+        const AstNode::ParallelFor* node;
+        std::shared_ptr<const Chunk> body;
+    };
+
+    struct Chunk
+    {
+        std::vector<Instruction> code {};
+        std::vector<LexToken::Source> sources {}; // one per instruction, only for diagnostics
+        std::vector<TemporaryValue::Any> constants {};
+        std::vector<ParallelLoop> parallelLoops {};
+        std::map<size_t, std::string> slotNames {}; // instruction index to variable name, only for diagnostics
+
+        size_t emit(OpCode op, uint32_t operand, const LexToken::Source& source);
+        size_t emitSlot(OpCode op, uint16_t depth, uint32_t slot, std::string_view name, const LexToken::Source& source);
+        size_t emit(OpCode op, const LexToken::Source& source) { return emit(op, 0, source); }
+        void patch(size_t at, uint32_t operand) { code[at].operand = operand; }
+        uint32_t here() const { return static_cast<uint32_t>(code.size()); }
+
+        uint32_t addConstant(TemporaryValue::Any value);
+    };
+
+    const char* toString(OpCode op);
+    std::string stringify(const Chunk& in);
+}
+
+std::ostream& operator<<(std::ostream& os, const ByteCode::Chunk& in);
@@ -0,0 +1,248 @@
+#include "ByteCodeCompiler.hpp"
+
+#include <ostream>
+
+#include "Diagnostics.hpp"
+
+using ByteCode::OpCode;
+
+static void compileNode(AstNode::NodePtr in, ByteCode::Chunk& chunk, bool preventNewScopeFromBlock = false);
+
+struct CompilerVisitor : public AstNode::IVisitor
+{
+    ByteCode::Chunk& chunk;
+    bool preventNewScopeFromBlock;
+
+    CompilerVisitor(ByteCode::Chunk& chunk, bool prevent_new_scope_from_block)
+        : chunk(chunk),
+          preventNewScopeFromBlock(prevent_new_scope_from_block)
+    {
+    }
+
+    void operator()(const AstNode::Identifier& v) override
+    {
+        chunk.emitSlot(OpCode::LoadSlot, v.depth, v.slot, v.tokenValue.content, v.tokenValue.source);
+    }
+
+    void operator()(const AstNode::Integer& v) override
+    {
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Integer{v.tokenValue.content}), v.tokenValue.source);
+    }
+    void operator()(const AstNode::Float& v) override
+    {
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Float{v.tokenValue.content}), v.tokenValue.source);
+    }
+    void operator()(const AstNode::String& v) override
+    {
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::String{std::string(v.value)}), v.tokenValue.source);
+    }
+
+    void operator()(const AstNode::Bool& v) override
+    {
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Bool{v.tokenValue.keyword == LexToken::Keyword::True}), v.tokenValue.source);
+    }
+    void operator()(const AstNode::UnaryOp& v) override
+    {
+        const auto op = TemporaryValue::toUnaryOperator(v.tokenValue.kind);
+        if(!op)
+        {
+            chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Any{}), v.tokenValue.source);
+            return;
+        }
+        compileNode(v.inner, chunk);
+        chunk.emit(OpCode::Unary, static_cast<uint32_t>(*op), v.tokenValue.source);
+    }
+    void operator()(const AstNode::BinaryOp& v) override
+    {
+        compileNode(v.left, chunk);
+
+        if(v.tokenValue.kind == LexToken::SeparatorKind::AndAnd || v.tokenValue.kind == LexToken::SeparatorKind::OrOr)
+        {
+            const auto jump = chunk.emit(v.tokenValue.kind == LexToken::SeparatorKind::AndAnd ? OpCode::AndJump : OpCode::OrJump, v.tokenValue.source);
+            compileNode(v.right, chunk);
+            chunk.emit(OpCode::ToBool, v.tokenValue.source);
+            chunk.patch(jump, chunk.here());
+            return;
+        }
+
+        const auto op = TemporaryValue::toBinaryOperator(v.tokenValue.kind);
+        if(!op)
+        {
+            diagnostics() << "\nCRITICAL COMPILER ERROR: unsupported operation:'" << v.tokenValue.content << "' " << v.tokenValue.source.printHint() << "here" << std::endl;
+            throw std::runtime_error("");
+        }
+        compileNode(v.right, chunk);
+        chunk.emit(OpCode::Binary, static_cast<uint32_t>(*op), v.tokenValue.source);
+    }
+    void operator()(const AstNode::ArrayLiteral& v) override
+    {
+        for(auto& it : v.elements)
+            compileNode(it, chunk);
+        chunk.emit(OpCode::MakeArray, static_cast<uint32_t>(v.elements.size()), v.tokenValue.source);
+    }
+    void operator()(const AstNode::Index& v) override
+    {
+        compileNode(v.target, chunk);
+        compileNode(v.index, chunk);
+        chunk.emit(OpCode::Index, v.tokenValue.source);
+    }
+    void operator()(const AstNode::BuiltinCall& v) override
+    {
+        for(auto& it : v.args)
+            compileNode(it, chunk);
+        chunk.emit(OpCode::Builtin, static_cast<uint32_t>(*TemporaryValue::toBuiltin(v.tokenValue.content)), v.tokenValue.source);
+    }
+    void operator()(const AstNode::Block& v) override
+    {
+        if(!preventNewScopeFromBlock)
+            pushScope(v.scopeSize, {});
+
+        if(v.statements.empty())
+            chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Any{}), {});
+
+        for(size_t i = 0; i != v.statements.size(); i++)
+        {
+            if(i != 0)
+                chunk.emit(OpCode::Pop, {});
+            compileNode(v.statements[i], chunk);
+        }
+
+        if(!preventNewScopeFromBlock)
+            popScope(v.scopeSize, {});
+    }
+    // scope declaring nothing is elided by AstResolver, no instructions for it
+    void pushScope(uint32_t size, const LexToken::Source& source)
+    {
+        if(size != 0)
+            chunk.emit(OpCode::PushScope, size, source);
+    }
+    void popScope(uint32_t size, const LexToken::Source& source)
+    {
+        if(size != 0)
+            chunk.emit(OpCode::PopScope, source);
+    }
+    void operator()(const AstNode::PrintStmt& v) override
+    {
+        compileNode(v.inner, chunk);
+        chunk.emit(OpCode::Print, v.tokenValue.source);
+    }
+    void operator()(const AstNode::IfStmt& v) override
+    {
+        compileNode(v.when, chunk);
+        const auto jumpElse = chunk.emit(OpCode::JumpIfFalse, v.tokenValue.source);
+
+        pushScope(v.thenScopeSize, v.tokenValue.source);
+        compileNode(v.then, chunk, true);
+        popScope(v.thenScopeSize, v.tokenValue.source);
+        const auto jumpEnd = chunk.emit(OpCode::Jump, v.tokenValue.source);
+
+        chunk.patch(jumpElse, chunk.here());
+        if(v.elseThen)
+        {
+            pushScope(v.elseScopeSize, v.tokenValue.source);
+            compileNode(v.elseThen, chunk, true);
+            popScope(v.elseScopeSize, v.tokenValue.source);
+        }
+        else
+            chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Any{}), v.tokenValue.source);
+
+        chunk.patch(jumpEnd, chunk.here());
+    }
+    void operator()(const AstNode::AssignStmt& v) override
+    {
+        auto asId = dynamic_cast<AstNode::Identifier*>(v.identifier);
+        if(!asId)
+        {
+            diagnostics() << v.tokenValue.source.printHint()  << "here \n";
+            throw std::runtime_error("");
+        }
+        compileNode(v.value, chunk);
+        chunk.emitSlot(OpCode::StoreSlot, asId->depth, asId->slot, asId->tokenValue.content, v.tokenValue.source);
+    }
+    void operator()(const AstNode::WhileStmt& v) override
+    {
+        pushScope(v.scopeSize, v.tokenValue.source);
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Bool{false}), v.tokenValue.source);
+
+        const auto loopStart = chunk.here();
+        compileNode(v.until, chunk);
+        const auto exitJump = chunk.emit(OpCode::JumpIfFalse, v.tokenValue.source);
+
+        chunk.emit(OpCode::Pop, v.tokenValue.source);
+        compileNode(v.loop, chunk, true);
+        chunk.emit(OpCode::Loop, loopStart, v.tokenValue.source);
+
+        chunk.patch(exitJump, chunk.here());
+        popScope(v.scopeSize, v.tokenValue.source);
+    }
+    void operator()(const AstNode::ForStmt& v) override
+    {
+        pushScope(v.scopeSize, v.tokenValue.source);
+        compileNode(v.doOnce, chunk, true);
+        chunk.emit(OpCode::Pop, v.tokenValue.source);
+
+        chunk.emit(OpCode::PushConst, chunk.addConstant(TemporaryValue::Bool{false}), v.tokenValue.source);
+
+        const auto loopStart = chunk.here();
+        compileNode(v.until, chunk);
+        const auto exitJump = chunk.emit(OpCode::JumpIfFalse, v.tokenValue.source);
+
+        chunk.emit(OpCode::Pop, v.tokenValue.source);
+        compileNode(v.loop, chunk, true);
+        compileNode(v.afterIter, chunk, true);
+        chunk.emit(OpCode::Pop, v.tokenValue.source);
+        chunk.emit(OpCode::Loop, loopStart, v.tokenValue.source);
+
+        chunk.patch(exitJump, chunk.here());
+        popScope(v.scopeSize, v.tokenValue.source);
+    }
+    void operator()(const AstNode::ParallelFor& v) override
+    {
+        compileNode(v.begin, chunk);
+        compileNode(v.end, chunk);
+
+        auto body = std::make_shared<ByteCode::Chunk>();
+        compileNode(v.body, *body, true);
+        chunk.parallelLoops.push_back(ByteCode::ParallelLoop{.node = &v, .body = std::move(body)});
+        chunk.emit(OpCode::ParallelFor, static_cast<uint32_t>(chunk.parallelLoops.size()-1), v.tokenValue.source);
+    }
+    void operator()(const AstNode::FunctionDecl& v) override
+    {
+        auto fn = TemporaryValue::Func{v};
+        fn.value->compiledAs<ByteCode::Chunk>([&fn]() { return ByteCodeCompiler().compileFunction(fn.decl()); });
+        chunk.emit(OpCode::PushConst, chunk.addConstant(std::move(fn)), v.tokenValue.source);
+    }
+    void operator()(const AstNode::FunctionCall& v) override
+    {
+        // arguments before callee, same order as the tree walker
+        for(auto& it : v.args)
+            compileNode(it, chunk);
+        compileNode(v.name, chunk);
+        chunk.emit(OpCode::Call, static_cast<uint32_t>(v.args.size()), v.tokenValue.source);
+    }
+    void operator()(const AstNode::Return& v) override
+    {
+        compileNode(v.inner, chunk);
+        chunk.emit(OpCode::Return, v.tokenValue.source);
+    }
+};
+
+static void compileNode(AstNode::NodePtr in, ByteCode::Chunk& chunk, bool preventNewScopeFromBlock)
+{
+    in->accept(CompilerVisitor(chunk,preventNewScopeFromBlock));
+}
+
+ByteCode::Chunk ByteCodeCompiler::compile(AstNode::NodePtr root)
+{
+    ByteCode::Chunk chunk;
+    compileNode(root, chunk, true);
+    return chunk;
+}
+
+ByteCode::Chunk ByteCodeCompiler::compileFunction(const AstNode::FunctionDecl& decl)
+{
+    ByteCode::Chunk chunk;
+    compileNode(decl.body, chunk, true);
+    chunk.emit(OpCode::Return, decl.tokenValue.source);
+    return chunk;
+}
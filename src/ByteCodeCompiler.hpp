@@ -0,0 +1,16 @@
+#pragma once
+
+#include "AstNode.hpp"
+#include "ByteCode.hpp"
+
+// Lowers AstNode tree into linear ByteCode::Chunk, executed by ByteCodeVm.
+// Every statement leaves exactly one value on the stack, same as treeWallInterpret result.
+class ByteCodeCompiler
+{
+public:
+    // compiles root the same way as treeWallInterpret(root,...,preventNewScopeFromBlock = true)
+    ByteCode::Chunk compile(AstNode::NodePtr root);
+
+    // body of the function executed in its own frame, always ends with Return
+    ByteCode::Chunk compileFunction(const AstNode::FunctionDecl& decl);
+};
@@ -0,0 +1,332 @@
+#include "ByteCodeVm.hpp"
+
+#include <ostream>
+
+#include "vx.hpp"
+
+#include "ByteCodeCompiler.hpp"
+#include "Diagnostics.hpp"
+#include "ParallelFor.hpp"
+
+using ByteCode::OpCode;
+
+TemporaryValue::Any ByteCodeVm::run(const ByteCode::Chunk& chunk, RuntimeScope* scope)
+{
+    stack.clear();
+    calls.clear();
+
+    RuntimeScope* localScope = scope ? scope : &context.globalScope;
+    const ByteCode::Chunk* current = &chunk;
+    const ByteCode::Instruction* code = current->code.data();
+    size_t ip = 0;
+
+    while(ip != current->code.size())
+    {
+        const auto& instruction = code[ip];
+        switch(instruction.opcode())
+        {
+            case OpCode::PushConst:
+                stack.push_back(current->constants[instruction.operand]);
+                break;
+            case OpCode::Pop:
+                stack.pop_back();
+                break;
+            case OpCode::LoadSlot:
+                if(auto var = localScope->getVariable(instruction.depth, instruction.operand))
+                    stack.push_back(*var);
+                else
+                    stack.emplace_back();
+                break;
+            case OpCode::StoreSlot:
+            {
+                auto& value = stack.back();
+                auto& scope = localScope->scopeAt(instruction.depth);
+                if(context.isSharedScope(scope)) [[unlikely]]
+                {
+                    diagnostics() << "can't assign global variable:'" << current->slotNames.at(ip) << "' inside pfor, functions called from its body only read globals\n";
+                    runtimeError(*current, ip);
+                }
+                auto& var = scope.slots[instruction.operand];
+                if(var && var->index() != value.index())
+                {
+                    diagnostics() << "forbitted redefintion variable:'" << current->slotNames.at(ip) << "' old value:'" << *var << "' new value:'" << value << "'\n";
+                    runtimeError(*current, ip);
+                }
+                var = value;
+                break;
+            }
+            case OpCode::PushScope:
+                localScope = &context.pushScope(*localScope, instruction.operand);
+                break;
+            case OpCode::PopScope:
+                localScope = localScope->parent;
+                context.popScope();
+                break;
+            case OpCode::Unary:
+                stack.back() = TemporaryValue::unaryOp(static_cast<TemporaryValue::UnaryOperator>(instruction.operand), stack.back());
+                break;
+            case OpCode::Binary:
+            {
+                // record operand types of the site and dispatch again to the specialized form
+                switch(TemporaryValue::operandTypes(stack[stack.size()-2], stack.back()))
+                {
+                    case TemporaryValue::OperandTypes::Integers:    instruction.quicken(OpCode::BinaryIntegers); break;
+                    case TemporaryValue::OperandTypes::Floats:      instruction.quicken(OpCode::BinaryFloats); break;
+                    default:                                        instruction.quicken(OpCode::BinaryGeneric); break;
+                }
+                continue;
+            }
+            case OpCode::BinaryIntegers:
+            {
+                auto& left = stack[stack.size()-2];
+                const auto& right = stack.back();
+                if(!left.is<TemporaryValue::Integer>() || !right.is<TemporaryValue::Integer>())
+                {
+                    instruction.quicken(OpCode::BinaryGeneric);
+                    continue;
+                }
+                try
+                {
+                    left = TemporaryValue::integerBinaryOp(static_cast<TemporaryValue::BinaryOperator>(instruction.operand),
+                        left.as<TemporaryValue::Integer>().value, right.as<TemporaryValue::Integer>().value);
+                }
+                catch(TemporaryValue::ArithmeticError&)
+                {
+                    runtimeError(*current, ip);
+                }
+                stack.pop_back();
+                break;
+            }
+            case OpCode::BinaryFloats:
+            {
+                auto& left = stack[stack.size()-2];
+                const auto& right = stack.back();
+                std::optional<TemporaryValue::Any> value;
+                if(TemporaryValue::operandTypes(left, right) == TemporaryValue::OperandTypes::Floats)
+                    value = TemporaryValue::floatBinaryOp(static_cast<TemporaryValue::BinaryOperator>(instruction.operand),
+                        TemporaryValue::numberAsFloat(left), TemporaryValue::numberAsFloat(right));
+                if(!value)
+                {
+                    instruction.quicken(OpCode::BinaryGeneric);
+                    continue;
+                }
+                left = std::move(*value);
+                stack.pop_back();
+                break;
+            }
+            case OpCode::BinaryGeneric:
+            {
+                auto right = std::move(stack.back());
+                stack.pop_back();
+                auto& left = stack.back();
+                std::optional<TemporaryValue::Any> value;
+                try
+                {
+                    value = TemporaryValue::binaryOp(static_cast<TemporaryValue::BinaryOperator>(instruction.operand), left, right);
+                }
+                catch(TemporaryValue::ArithmeticError&)
+                {
+                    runtimeError(*current, ip);
+                }
+                if(!value)
+                {
+                    diagnostics() << "unsupported operation between left:'" << left << "' and right:'" << right << "'\n";
+                    runtimeError(*current, ip);
+                }
+                left = std::move(*value);
+                break;
+            }
+            case OpCode::AndJump:
+            case OpCode::OrJump:
+            {
+                if(!(stack.back()|vx::is<TemporaryValue::Bool>))
+                {
+                    diagnostics() << "unsupported operation:'" << (instruction.opcode() == OpCode::AndJump ? "&&" : "||") << "' on left:'" << stack.back() << "'\n";
+                    runtimeError(*current, ip);
+                }
+                if(TemporaryValue::getBool(stack.back()) == (instruction.opcode() == OpCode::OrJump))
+                {
+                    ip = instruction.operand;
+                    continue;
+                }
+                stack.pop_back();
+                break;
+            }
+            case OpCode::ToBool:
+                stack.back() = TemporaryValue::Bool{TemporaryValue::getBool(stack.back())};
+                break;
+            case OpCode::Jump:
+                ip = instruction.operand;
+                continue;
+            case OpCode::JumpIfFalse:
+            {
+                const bool when = TemporaryValue::getBool(stack.back());
+                stack.pop_back();
+                if(!when)
+                {
+                    ip = instruction.operand;
+                    continue;
+                }
+                break;
+            }
+            case OpCode::Loop:
+                if(!context.consumeFuel()) [[unlikely]]
+                    budgetExhausted(*current, ip);
+                ip = instruction.operand;
+                continue;
+            case OpCode::Print:
+                TemporaryValue::print(context.output, stack.back());
+                break;
+            case OpCode::MakeArray:
+            {
+                const size_t count = instruction.operand;
+                auto value = TemporaryValue::makeArray(stack.data() + stack.size() - count, count);
+                if(!value)
+                {
+                    diagnostics() << "array elements must be numbers\n";
+                    runtimeError(*current, ip);
+                }
+                stack.resize(stack.size() - count);
+                stack.push_back(std::move(*value));
+                break;
+            }
+            case OpCode::Index:
+            {
+                auto& target = stack[stack.size()-2];
+                auto value = TemporaryValue::indexArray(target, stack.back());
+                if(!value)
+                {
+                    diagnostics() << "unsupported index:'" << stack.back() << "' of:'" << target << "'\n";
+                    runtimeError(*current, ip);
+                }
+                stack.pop_back();
+                stack.back() = std::move(*value);
+                break;
+            }
+            case OpCode::Builtin:
+            {
+                const auto fn = static_cast<TemporaryValue::Builtin>(instruction.operand);
+                const size_t argc = TemporaryValue::builtinArity(fn);
+                const auto* args = stack.data() + stack.size() - argc;
+                auto value = TemporaryValue::callBuiltin(fn, args);
+                if(!value)
+                {
+                    diagnostics() << "unsupported arguments of builtin function:";
+                    for(size_t i = 0; i != argc; i++)
+                        diagnostics() << " '" << args[i] << "'";
+                    diagnostics() << "\n";
+                    runtimeError(*current, ip);
+                }
+                stack.resize(stack.size() - argc);
+                stack.push_back(std::move(*value));
+                break;
+            }
+            case OpCode::ParallelFor:
+            {
+                const auto& loop = current->parallelLoops[instruction.operand];
+                auto value = runParallelFor(*loop.node, context, *localScope, stack[stack.size()-2], stack.back(), [&loop](RuntimeContext& worker)
+                {
+                    return [vm = ByteCodeVm(worker), body = loop.body.get()](RuntimeScope& scope) mutable { return vm.run(*body, &scope); };
+                });
+                stack.pop_back();
+                stack.back() = std::move(value);
+                break;
+            }
+            case OpCode::Call:
+            {
+                const uint32_t argc = instruction.operand;
+                auto& callee = stack.back();
+                if(!(callee|vx::is<TemporaryValue::Func>))
+                {
+                    diagnostics() << "that is not a function\n";
+                    runtimeError(*current, ip);
+                }
+
+                auto& fn = callee|vx::as<TemporaryValue::Func>;
+                auto& decl = fn.decl();
+                if(decl.params.size() != argc)
+                {
+                    diagnostics() << "not matching number of arguments\n";
+                    runtimeError(*current, ip);
+                }
+                if(context.callDepth() == MAX_CALL_DEPTH)
+                {
+                    diagnostics() << "exceeded max call depth\n";
+                    runtimeError(*current, ip);
+                }
+                if(!context.consumeFuel()) [[unlikely]]
+                    budgetExhausted(*current, ip);
+                // compiled already unless declared while running the tree walker
+                const auto* body = &fn.value->compiledAs<ByteCode::Chunk>([&decl]() { return ByteCodeCompiler().compileFunction(decl); });
+
+                auto& frame = context.pushFrame(decl.scopeSize);
+                const size_t argsBase = stack.size()-1-argc;
+                for(uint32_t i = 0; i != argc; i++)
+                    frame.slots[i] = std::move(stack[argsBase+i]);
+                if(argc != 0)
+                {
+                    stack[argsBase] = std::move(callee);
+                    stack.resize(argsBase+1);
+                }
+
+                calls.push_back(CallFrame{
+                    .chunk = current,
+                    .returnIp = ip+1,
+                    .returnScope = localScope,
+                    .stackBase = stack.size(),
+                    .scopesBase = context.scopeCount(),
+                });
+
+                current = body; // FuncBody is kept alive by callee left on the stack
+                code = current->code.data();
+                localScope = &frame;
+                ip = 0;
+                continue;
+            }
+            case OpCode::Return:
+            {
+                if(calls.empty())
+                {
+                    context.completion = RuntimeContext::Completion::Return;
+                    context.returnValue = stack.back();
+                    return std::move(stack.back());
+                }
+
+                auto result = std::move(stack.back());
+                const auto frame = calls.back();
+                calls.pop_back();
+                context.popFrame();
+
+                while(context.scopeCount() != frame.scopesBase)
+                    context.popScope();
+
+                current = frame.chunk;
+                code = current->code.data();
+                localScope = frame.returnScope;
+                ip = frame.returnIp;
+
+                stack.resize(frame.stackBase-1); // drops callee, after leaving its chunk
+                stack.push_back(std::move(result));
+                continue;
+            }
+        }
+        ip++;
+    }
+
+    if(stack.empty())
+        return {};
+    return std::move(stack.back());
+}
+
+void ByteCodeVm::budgetExhausted(const ByteCode::Chunk& chunk, size_t ip) const
+{
+    diagnostics() << "budget exhausted: " << context.exhaustedReason() << "\n";
+    diagnostics() << chunk.sources[ip].printHint() << "here \n";
+    throw BudgetExhausted();
+}
+
+void ByteCodeVm::runtimeError(const ByteCode::Chunk& chunk, size_t ip) const
+{
+    diagnostics() << chunk.sources[ip].printHint() << "here \n";
+    throw std::runtime_error("");
+}
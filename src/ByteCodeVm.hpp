@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "ByteCode.hpp"
+#include "RuntimeScope.hpp"
+#include "TemporaryValue.hpp"
+
+// Dispatch loop executing ByteCode::Chunk, alternative backend to treeWallInterpret.
+class ByteCodeVm
+{
+public:
+    explicit ByteCodeVm(RuntimeContext& inContext) : context(inContext) {};
+
+    // stops at the end of chunk or at 'ret', which is reported through context completion,
+    // runs in scope instead of the global scope when given
+    TemporaryValue::Any run(const ByteCode::Chunk& chunk, RuntimeScope* scope = nullptr);
+
+protected:
+    struct CallFrame
+    {
+        const ByteCode::Chunk* chunk;
+        size_t returnIp;
+        RuntimeScope* returnScope;
+        size_t stackBase;       // stack size with callee left on top, it owns executed chunk
+        size_t scopesBase;
+    };
+
+    [[noreturn]] void budgetExhausted(const ByteCode::Chunk& chunk, size_t ip) const;
+    [[noreturn]] void runtimeError(const ByteCode::Chunk& chunk, size_t ip) const;
+
+    RuntimeContext& context;
+    std::vector<TemporaryValue::Any> stack {};
+    std::vector<CallFrame> calls {};
+};
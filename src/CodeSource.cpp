@@ -0,0 +1,151 @@
+#include "CodeSource.hpp"
+
+#include <bit>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define QLANG_HAS_MMAP 1
+#endif
+
+CodeSource::~CodeSource()
+{
+#ifdef QLANG_HAS_MMAP
+    if(mapped)
+        munmap(const_cast<char*>(mapped), mappedSize+1);
+#endif
+}
+
+std::shared_ptr<CodeSource> CodeSource::fromFile(const std::string& path)
+{
+    auto result = std::make_shared<CodeSource>(path);
+
+#ifdef QLANG_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category());
+
+    struct stat info {};
+    if(fstat(fd, &info) != 0 || S_ISDIR(info.st_mode))
+    {
+        const int error = S_ISDIR(info.st_mode) ? EISDIR : errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category());
+    }
+    if(info.st_size == 0)
+    {
+        close(fd);
+        return result; // empty file, nothing to map
+    }
+
+    // reserve one byte more than the file, so text is followed by zero filled '\0' even when file size is page aligned
+    const auto size = static_cast<size_t>(info.st_size);
+    void* reserved = mmap(nullptr, size+1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* file = reserved == MAP_FAILED ? MAP_FAILED : mmap(reserved, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    const int error = errno;
+    close(fd);
+
+    if(file == MAP_FAILED)
+    {
+        if(reserved != MAP_FAILED)
+            munmap(reserved, size+1);
+        throw std::system_error(error, std::generic_category());
+    }
+
+    result->mapped = static_cast<const char*>(file);
+    result->mappedSize = size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+        throw std::system_error(errno, std::generic_category());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    result->content = buffer.str();
+#endif
+
+    return result;
+}
+
+std::mutex CodeSourceRegistry::mutex {};
+uint32_t CodeSourceRegistry::nextId {NO_SOURCE + 1};
+std::array<std::atomic<CodeSourceRegistry::Slot*>, CodeSourceRegistry::SEGMENTS> CodeSourceRegistry::segments {};
+
+// segment k holds ids [2^(k+FIRST_SEGMENT_BITS) - 2^FIRST_SEGMENT_BITS, 2^(k+1+FIRST_SEGMENT_BITS) - 2^FIRST_SEGMENT_BITS)
+size_t CodeSourceRegistry::segmentOf(uint32_t id)
+{
+    const uint64_t position = uint64_t{id} + (uint64_t{1} << FIRST_SEGMENT_BITS);
+    return static_cast<size_t>(std::bit_width(position)) - FIRST_SEGMENT_BITS - 1;
+}
+
+// null when the segment of id was never allocated
+CodeSourceRegistry::Slot* CodeSourceRegistry::slot(uint32_t id)
+{
+    const size_t segment = segmentOf(id);
+    Slot* slots = segments[segment].load(std::memory_order_acquire);
+    if(!slots)
+        return nullptr;
+    return &slots[uint64_t{id} + (uint64_t{1} << FIRST_SEGMENT_BITS) - (uint64_t{1} << (segment + FIRST_SEGMENT_BITS))];
+}
+
+uint32_t CodeSourceRegistry::add(std::shared_ptr<const CodeSource> inSource)
+{
+    std::lock_guard lock(mutex);
+    if(nextId == UINT32_MAX)
+        throw std::length_error("too many code sources");
+
+    const uint32_t id = nextId++;
+    Slot* found = slot(id);
+    if(!found)
+    {
+        // allocated on the first id of a segment, kept for the rest of the process as readers may hold pointers into it
+        const size_t segment = segmentOf(id);
+        segments[segment].store(new Slot[size_t{1} << (segment + FIRST_SEGMENT_BITS)], std::memory_order_release);
+        found = slot(id);
+    }
+
+    found->owned = std::move(inSource);
+    found->references = 1;
+    found->source.store(found->owned.get(), std::memory_order_release);
+    return id;
+}
+
+const CodeSource& CodeSourceRegistry::get(uint32_t id)
+{
+    static const CodeSource none("<none>");
+    const Slot* found = id == NO_SOURCE ? nullptr : slot(id);
+    const CodeSource* source = found ? found->source.load(std::memory_order_acquire) : nullptr;
+    return source ? *source : none;
+}
+
+void CodeSourceRegistry::retain(uint32_t id)
+{
+    std::lock_guard lock(mutex);
+    if(id == NO_SOURCE || id >= nextId)
+        return;
+    Slot* found = slot(id);
+    if(found->references != 0)
+        found->references++;
+}
+
+void CodeSourceRegistry::release(uint32_t id)
+{
+    std::shared_ptr<const CodeSource> last;
+    {
+        std::lock_guard lock(mutex);
+        if(id == NO_SOURCE || id >= nextId)
+            return;
+        Slot* found = slot(id);
+        if(found->references == 0 || --found->references != 0)
+            return;
+        found->source.store(nullptr, std::memory_order_release);
+        last = std::move(found->owned);
+    }
+    // unmapping a file source may take a while, done outside the lock
+}
@@ -1,43 +1,108 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 struct CodeSource
 {
+    explicit CodeSource(std::string inName, std::string inContent = {}) : name(std::move(inName)), content(std::move(inContent)) {};
+    ~CodeSource();
+
+    CodeSource(const CodeSource&) = delete;
+    CodeSource& operator=(const CodeSource&) = delete;
+
+    // maps file read-only instead of copying it into content, falls back to reading where mmap is unavailable.
+    // Throws std::system_error with the reason when file cannot be read.
+    static std::shared_ptr<CodeSource> fromFile(const std::string& path);
+
     std::string name;
-    std::string content;
+    std::string content; // used when source is not file-backed
+
+    // source text, always followed by '\0' which lexer relies on as end marker
+    std::string_view text() const { return mapped ? std::string_view(mapped, mappedSize) : std::string_view(content); }
+
+    // offset of the first character of line (1 based), text().size() for lines past the end
+    size_t lineStart(size_t line) const
+    {
+        const auto chars = text();
+        std::call_once(lineStartsBuilt, [this, chars]()
+        {
+            lineStarts.push_back(0);
+            for(size_t i = 0; i < chars.size(); i++)
+                if(chars[i] == '\n')
+                    lineStarts.push_back(i+1);
+        });
+
+        if(line == 0 || line > lineStarts.size())
+            return chars.size();
+        return lineStarts[line-1];
+    }
 
     std::string printHint(size_t line, size_t character) const
     {
         std::string linePrefix = std::to_string(line) + "] ";
-        size_t currentLine = 1;
-        size_t startChar = 0;
-
-        if (line > 1)
-            for(size_t i = 0; i < content.size(); i++)
-            {
-                if(content[i] == '\n')
-                    currentLine++;
-
-                if(currentLine == line)
-                {
-                    startChar = i+1;
-                    break;
-                }
-            }
+        const auto chars = text();
+        const size_t startChar = lineStart(line);
+        size_t endChar = chars.find('\n', startChar);
+        if(endChar == std::string_view::npos)
+            endChar = chars.size();
 
         std::string result= "in <"+name+">:"+std::to_string(line)+":"+std::to_string(character)+"\n"+linePrefix;
-        for(size_t i = startChar; i < content.size(); i++)
-        {
-            if(content[i] == '\n')
-                break;
-
-            result += content[i];
-        }
+        result.append(chars, startChar, endChar-startChar);
         result += '\n';
 
-        for(int i=0; i!=character+linePrefix.size()-1;i++) result += " ";
+        result.append(character+linePrefix.size()-1, ' ');
         result += " ^ ";
         return result;
     }
+
+private:
+    const char* mapped {nullptr};
+    size_t mappedSize {0};
+
+    // built lazily on first diagnostic, content must not change afterwards
+    mutable std::once_flag lineStartsBuilt {};
+    mutable std::vector<size_t> lineStarts {};
+};
+
+// Tokens refer to their CodeSource by compact id instead of owning pointer, so copying token is free.
+// Registered source stays alive while references to it are held; id 0 is reserved for "no source".
+// Lookups are lock free, registering and releasing take a mutex.
+class CodeSourceRegistry
+{
+public:
+    static constexpr uint32_t NO_SOURCE = 0;
+
+    // the caller holds the first reference
+    static uint32_t add(std::shared_ptr<const CodeSource> inSource);
+    // caller must hold a reference to id, released or unknown ids give the "<none>" source
+    static const CodeSource& get(uint32_t id);
+    // another reference, for holders which outlive the one that added the source
+    static void retain(uint32_t id);
+    // drops one reference, the source is unregistered with the last one
+    static void release(uint32_t id);
+
+private:
+    // slots are split into segments doubling in size, so a segment never moves once published
+    static constexpr uint32_t FIRST_SEGMENT_BITS = 6;
+    static constexpr size_t SEGMENTS = 32 - FIRST_SEGMENT_BITS + 1;
+
+    struct Slot
+    {
+        std::atomic<const CodeSource*> source {};
+        std::shared_ptr<const CodeSource> owned {}; // guarded by mutex
+        uint32_t references {};                     // guarded by mutex
+    };
+
+    static size_t segmentOf(uint32_t id);
+    static Slot* slot(uint32_t id);
+
+    static std::mutex mutex;
+    static uint32_t nextId;
+    static std::array<std::atomic<Slot*>, SEGMENTS> segments;
 };
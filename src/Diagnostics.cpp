@@ -0,0 +1,23 @@
+#include "Diagnostics.hpp"
+
+#include <iostream>
+
+namespace
+{
+    thread_local std::ostream* redirected = nullptr;
+}
+
+std::ostream& diagnostics()
+{
+    return redirected ? *redirected : std::cout;
+}
+
+DiagnosticsRedirect::DiagnosticsRedirect(std::ostream& to) : previous(redirected)
+{
+    redirected = &to;
+}
+
+DiagnosticsRedirect::~DiagnosticsRedirect()
+{
+    redirected = previous;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <ostream>
+
+// Stream of messages printed before throwing on error, std::cout unless redirected on the calling thread.
+std::ostream& diagnostics();
+
+// Redirects diagnostics() of the calling thread while alive, lets embedders keep messages of one run.
+class DiagnosticsRedirect
+{
+public:
+    explicit DiagnosticsRedirect(std::ostream& to);
+    ~DiagnosticsRedirect();
+
+    DiagnosticsRedirect(const DiagnosticsRedirect&) = delete;
+    DiagnosticsRedirect& operator=(const DiagnosticsRedirect&) = delete;
+
+private:
+    std::ostream* previous;
+};
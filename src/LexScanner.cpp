@@ -1,8 +1,10 @@
 #include "LexScanner.hpp"
+#include "LexSimd.hpp"
+#include "Diagnostics.hpp"
 
 #include <algorithm>
 #include <assert.h>
-#include <iostream>
+#include <charconv>
 #include <stack>
 #include <ostream>
 
@@ -10,29 +12,30 @@
 
 LexScanner::LexScanner(std::shared_ptr<CodeSource> inSource, const std::vector<std::string>& inSeparators)
 :   source(std::move(inSource)),
-    separators(inSeparators)
+    sourceId(CodeSourceRegistry::add(source)),
+    chars(source->text().data()),
+    charsSize(source->text().size()),
+    separators(inSeparators),
+    separatorTrie(inSeparators)
 {
+    for(auto& it : separators)
+        separatorKinds.push_back(LexToken::toSeparatorKind(it));
     next();
 }
 
 std::optional<LexToken::Any> LexScanner::next()
 {
     auto beginIdx = positionIdx;
-    while(source->content[positionIdx] != '\0')
+    while(chars[positionIdx] != '\0')
     {
-        auto charIt = source->content[positionIdx];
+        auto charIt = chars[positionIdx];
 
-        if(charIt == '\n')
+        if(isspace(charIt)) // ignore whitespace, counting lines on the way
         {
-            positionIdx++;
-            newLinePosition = positionIdx;
-            currentLine++;
-            continue;
-        }
-
-        if(isspace(charIt)) // ignore whitespace
-        {
-            positionIdx++;
+            const auto run = LexSimd::skipWhitespace(chars, positionIdx, charsSize, newLinePosition);
+            positionIdx = run.end;
+            newLinePosition = run.lastLineStart;
+            currentLine += run.newLines;
             continue;
         }
         else if(tryTokenizeSeparator())
@@ -53,8 +56,8 @@ std::optional<LexToken::Any> LexScanner::next()
         }
         else
         {
-            std::cout << "\nCRITICAL SCANNER ERROR " << source->printHint(currentLine,positionIdx) << "unexpected character" << std::endl;
-            throw std::runtime_error( "unidentified token starting with:" + std::to_string(static_cast<char>(source->content[positionIdx])) + " at: "+ std::to_string(positionIdx));
+            diagnostics() << "\nCRITICAL SCANNER ERROR " << source->printHint(currentLine,positionIdx) << "unexpected character" << std::endl;
+            throw std::runtime_error( "unidentified token starting with:" + std::to_string(static_cast<char>(chars[positionIdx])) + " at: "+ std::to_string(positionIdx));
             break;
         }
     }
@@ -73,62 +76,60 @@ void LexScanner::restart()
 
 bool LexScanner::tryTokenizeNumber()
 {
-    if(!isdigit(source->content[positionIdx])) return false;
+    if(!isdigit(chars[positionIdx])) return false;
 
-    std::string summed;
     const size_t startPositionIdx = positionIdx;
-    bool containsDot = false;
-    while(positionIdx != source->content.size())
-    {
-        auto charIt = source->content[positionIdx];
+    positionIdx = LexSimd::skipDigits(chars, positionIdx, charsSize);
 
-        if(isdigit(charIt))
-        {
-            summed += charIt;
-            positionIdx++;
-        }
-        else if(charIt=='.' and !containsDot)
-        {
-            containsDot = true;
-            summed += charIt;
-            positionIdx++;
-        }
-        else
-        {
-            break;
-        }
-    }
+    const bool containsDot = chars[positionIdx] == '.';
+    if(containsDot)
+        positionIdx = LexSimd::skipDigits(chars, positionIdx+1, charsSize);
+
+    const char* first = chars + startPositionIdx;
+    const char* last = chars + positionIdx;
 
+    std::from_chars_result parsed {};
     if(containsDot)
     {
-        currentToken = LexToken::Float{makeSource(startPositionIdx),std::stof(summed)};
-        return true;
+        LexToken::Float token {makeSource(startPositionIdx)};
+        parsed = std::from_chars(first, last, token.content);
+        currentToken = token;
+    }
+    else
+    {
+        LexToken::Integer token {makeSource(startPositionIdx)};
+        parsed = std::from_chars(first, last, token.content);
+        currentToken = token;
     }
 
-
-    currentToken = LexToken::Integer{makeSource(startPositionIdx),std::stoi(summed)};
+    if(parsed.ec != std::errc())
+    {
+        diagnostics() << "\nCRITICAL SCANNER ERROR " << source->printHint(currentLine,startPositionIdx-newLinePosition) << "number out of range" << std::endl;
+        throw std::runtime_error("");
+    }
     return true;
 }
 
 bool LexScanner::tryTokenizeString()
 {
-    if(source->content[positionIdx] != '"') return false;
+    if(chars[positionIdx] != '"') return false;
 
     positionIdx++;
     auto beginIdx = positionIdx;
 
-    while(source->content[positionIdx] != '\0')
+    while(chars[positionIdx] != '\0')
     {
-        auto prevCharIt = source->content[positionIdx-1];
-        auto charIt = source->content[positionIdx];
+        auto prevCharIt = chars[positionIdx-1];
+        auto charIt = chars[positionIdx];
 
         if(charIt == '"' && prevCharIt != '\\') // allow escape code
             break;
 
         positionIdx++;
     }
-    positionIdx++; // escape string
-    currentToken = LexToken::String{makeSource(beginIdx),source->content.substr(beginIdx,positionIdx-beginIdx-1)};
+    currentToken = LexToken::String{makeSource(beginIdx),std::string_view(chars+beginIdx,positionIdx-beginIdx)};
+    if(chars[positionIdx] != '\0') // unterminated string ends at the end of source, never step over '\0'
+        positionIdx++;
     return true;
 }
 
@@ -136,56 +137,33 @@ bool LexScanner::tryTokenizeSeparator()
 {
     auto beginIdx = positionIdx;
 
-    std::string matched {};
-    for(auto& operatIt : separators)
-    {
-        bool match {true};
-        for(int operatCharIdx = 0; operatCharIdx != operatIt.size();operatCharIdx++)
-        {
-            if(source->content[beginIdx+operatCharIdx] != operatIt[operatCharIdx])
-            {
-                match = false;
-                break;
-            }
-        }
-        if(!match) continue;
-        if(matched.size() < operatIt.size()) matched = operatIt; // keep longer match
-    }
+    const int matched = separatorTrie.match(chars + beginIdx);
+    if(matched == LexSeparatorTrie::NO_MATCH) return false;
 
-    if(matched.empty()) return false;
-
-    positionIdx += matched.size();
-    currentToken = LexToken::Separator{makeSource(beginIdx),matched};
+    positionIdx += separators[matched].size();
+    currentToken = LexToken::Separator{makeSource(beginIdx),std::string_view(chars+beginIdx,positionIdx-beginIdx),separatorKinds[matched]};
     return true;
 }
 
 bool LexScanner::tryTokenizeLabel()
 {
-    if(!((source->content[positionIdx] >= 'a' && source->content[positionIdx] <= 'z') || (source->content[positionIdx] >= 'A' && source->content[positionIdx] <= 'Z')))
+    if(!((chars[positionIdx] >= 'a' && chars[positionIdx] <= 'z') || (chars[positionIdx] >= 'A' && chars[positionIdx] <= 'Z')))
         return false;
 
     auto beginIdx = positionIdx;
-    while(source->content[positionIdx] != '\0')
-    {
-        auto charIt = source->content[positionIdx];
-
-        if ((charIt >= '0' && charIt <= '9') || (charIt >= 'A' && charIt <= 'Z') ||
-            (charIt >= 'a' && charIt <= 'z') || charIt == '_')
-        {
-            positionIdx++;
-        } else break;
-    }
+    positionIdx = LexSimd::skipIdentifier(chars, positionIdx, charsSize);
 
-    currentToken = LexToken::Label{makeSource(beginIdx),source->content.substr(beginIdx,positionIdx-beginIdx)};
+    auto content = std::string_view(chars+beginIdx,positionIdx-beginIdx);
+    currentToken = LexToken::Label{makeSource(beginIdx),content,LexToken::toKeyword(content)};
     return true;
 }
 
 LexToken::Source LexScanner::makeSource(size_t startingCharacter) const
 {
     return LexToken::Source {
-        .fromSource = source,
-        .atLine =  currentLine,
-        .startingCharacter = startingCharacter-newLinePosition,
+        .sourceId = sourceId,
+        .atLine = static_cast<uint32_t>(currentLine),
+        .startingCharacter = static_cast<uint32_t>(startingCharacter-newLinePosition),
     };
 }
 
@@ -2,6 +2,7 @@
 #include <memory>
 #include <optional>
 
+#include "LexSeparatorTrie.hpp"
 #include "LexToken.hpp"
 #include "CodeSource.hpp"
 
@@ -14,6 +15,9 @@ public:
     std::optional<LexToken::Any> current() {return currentToken;};
     void restart();
 
+    const std::shared_ptr<CodeSource>& getSource() const { return source; }
+    uint32_t getSourceId() const { return sourceId; }
+
     template<typename T>
     std::optional<T> current()
     {
@@ -36,6 +40,26 @@ public:
         return {};
     }
 
+    std::optional<LexToken::Separator> currentMath(LexToken::SeparatorKind expected)
+    {
+        if(auto v = current<LexToken::Separator>())
+        {
+            if(v->kind == expected)
+                return v;
+        }
+        return {};
+    }
+
+    std::optional<LexToken::Label> currentMath(LexToken::Keyword expected)
+    {
+        if(auto v = current<LexToken::Label>())
+        {
+            if(v->keyword == expected)
+                return v;
+        }
+        return {};
+    }
+
 protected:
     bool tryTokenizeNumber();
     bool tryTokenizeString();
@@ -45,9 +69,14 @@ protected:
     LexToken::Source makeSource(size_t startingCharacter) const;
 
     std::shared_ptr<CodeSource> source;
+    uint32_t sourceId;
+    const char* chars; // CodeSource::text(), null terminated
+    size_t charsSize;
     size_t currentLine {1};
     size_t newLinePosition {0};
     size_t positionIdx {};
     std::optional<LexToken::Any> currentToken {};
     std::vector<std::string> separators {};
+    std::vector<LexToken::SeparatorKind> separatorKinds {};
+    LexSeparatorTrie separatorTrie;
 };
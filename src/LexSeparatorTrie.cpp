@@ -0,0 +1,27 @@
+#include "LexSeparatorTrie.hpp"
+
+#include <stdexcept>
+
+LexSeparatorTrie::LexSeparatorTrie(const std::vector<std::string>& separators)
+:   nodes(1)
+{
+    for(int separatorIdx = 0; separatorIdx != static_cast<int>(separators.size()); separatorIdx++)
+    {
+        uint16_t nodeIdx = 0;
+        for(const char charIt : separators[separatorIdx])
+        {
+            auto& next = nodes[nodeIdx].next[static_cast<unsigned char>(charIt)];
+            if(next == 0)
+            {
+                if(nodes.size() == UINT16_MAX)
+                    throw std::runtime_error("too many separators");
+
+                next = static_cast<uint16_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            nodeIdx = nodes[nodeIdx].next[static_cast<unsigned char>(charIt)];
+        }
+        if(nodeIdx != 0 && nodes[nodeIdx].separator == NO_MATCH)
+            nodes[nodeIdx].separator = separatorIdx;
+    }
+}
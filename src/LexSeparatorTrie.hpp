@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Finds the longest separator at given position in one pass over the input,
+// built once from separators list of LexScanner.
+class LexSeparatorTrie
+{
+public:
+    static constexpr int NO_MATCH = -1;
+
+    explicit LexSeparatorTrie(const std::vector<std::string>& separators);
+
+    // returns index into separators of the longest one starting at in, NO_MATCH when none.
+    // in has to be null terminated, separators never contain '\0'
+    int match(const char* in) const
+    {
+        int matched = NO_MATCH;
+        uint16_t nodeIdx = 0;
+        for(const char* it = in; ; it++)
+        {
+            nodeIdx = nodes[nodeIdx].next[static_cast<unsigned char>(*it)];
+            if(nodeIdx == 0)
+                return matched;
+            if(nodes[nodeIdx].separator != NO_MATCH)
+                matched = nodes[nodeIdx].separator;
+        }
+    }
+
+protected:
+    struct Node
+    {
+        std::array<uint16_t, 256> next {}; // 0 means no transition, root is never a target
+        int separator {NO_MATCH};
+    };
+
+    std::vector<Node> nodes;
+};
@@ -0,0 +1,212 @@
+#include "LexSimd.hpp"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define QLANG_LEX_X86 1
+#endif
+
+namespace
+{
+    using WhitespaceRun = LexSimd::WhitespaceRun;
+
+    bool isWhitespace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    bool isIdentifier(char c)
+    {
+        const char lower = static_cast<char>(c | 0x20);
+        return isDigit(c) || (lower >= 'a' && lower <= 'z') || c == '_';
+    }
+
+    WhitespaceRun skipWhitespaceScalar(const char* chars, size_t from, size_t size, size_t lineStart)
+    {
+        WhitespaceRun run {from, 0, lineStart};
+        for(; run.end != size && isWhitespace(chars[run.end]); run.end++)
+        {
+            if(chars[run.end] == '\n')
+            {
+                run.newLines++;
+                run.lastLineStart = run.end+1;
+            }
+        }
+        return run;
+    }
+
+    [[maybe_unused]] size_t skipIdentifierScalar(const char* chars, size_t from, size_t size)
+    {
+        while(from != size && isIdentifier(chars[from])) from++;
+        return from;
+    }
+
+    [[maybe_unused]] size_t skipDigitsScalar(const char* chars, size_t from, size_t size)
+    {
+        while(from != size && isDigit(chars[from])) from++;
+        return from;
+    }
+
+#ifdef QLANG_LEX_X86
+    // unsigned lo <= v <= hi per byte
+    __m128i inRangeSse2(__m128i v, char lo, char hi)
+    {
+        const auto geLo = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(lo)), v);
+        const auto leHi = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(hi)), v);
+        return _mm_and_si128(geLo, leHi);
+    }
+
+    uint32_t whitespaceMaskSse2(__m128i v)
+    {
+        return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), inRangeSse2(v, '\t', '\r')));
+    }
+
+    uint32_t digitMaskSse2(__m128i v)
+    {
+        return _mm_movemask_epi8(inRangeSse2(v, '0', '9'));
+    }
+
+    uint32_t identifierMaskSse2(__m128i v)
+    {
+        const auto letter = inRangeSse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        const auto underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, underscore), inRangeSse2(v, '0', '9')));
+    }
+
+    template<uint32_t (*TMask)(__m128i), bool (*TScalar)(char)>
+    size_t skipSse2(const char* chars, size_t from, size_t size)
+    {
+        for(; from + 16 <= size; from += 16)
+        {
+            const uint32_t stop = ~TMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + from))) & 0xFFFF;
+            if(stop)
+                return from + std::countr_zero(stop);
+        }
+        while(from != size && TScalar(chars[from])) from++;
+        return from;
+    }
+
+    WhitespaceRun skipWhitespaceSse2(const char* chars, size_t from, size_t size, size_t lineStart)
+    {
+        WhitespaceRun run {from, 0, lineStart};
+        for(; run.end + 16 <= size; run.end += 16)
+        {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + run.end));
+            const uint32_t stop = ~whitespaceMaskSse2(v) & 0xFFFF;
+            const uint32_t inRun = stop ? (1u << std::countr_zero(stop)) - 1 : 0xFFFF;
+            const uint32_t newLines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))) & inRun;
+
+            if(newLines)
+            {
+                run.newLines += std::popcount(newLines);
+                run.lastLineStart = run.end + 32 - std::countl_zero(newLines);
+            }
+            if(stop)
+                return WhitespaceRun {run.end + std::countr_zero(stop), run.newLines, run.lastLineStart};
+        }
+        const auto tail = skipWhitespaceScalar(chars, run.end, size, run.lastLineStart);
+        return WhitespaceRun {tail.end, run.newLines + tail.newLines, tail.lastLineStart};
+    }
+
+    __attribute__((target("avx2"))) __m256i inRangeAvx2(__m256i v, char lo, char hi)
+    {
+        const auto geLo = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(lo)), v);
+        const auto leHi = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(hi)), v);
+        return _mm256_and_si256(geLo, leHi);
+    }
+
+    __attribute__((target("avx2"))) uint32_t whitespaceMaskAvx2(__m256i v)
+    {
+        return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), inRangeAvx2(v, '\t', '\r')));
+    }
+
+    __attribute__((target("avx2"))) uint32_t digitMaskAvx2(__m256i v)
+    {
+        return _mm256_movemask_epi8(inRangeAvx2(v, '0', '9'));
+    }
+
+    __attribute__((target("avx2"))) uint32_t identifierMaskAvx2(__m256i v)
+    {
+        const auto letter = inRangeAvx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        const auto underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, underscore), inRangeAvx2(v, '0', '9')));
+    }
+
+    template<uint32_t (*TMask)(__m256i), bool (*TScalar)(char)>
+    __attribute__((target("avx2"))) size_t skipAvx2(const char* chars, size_t from, size_t size)
+    {
+        for(; from + 32 <= size; from += 32)
+        {
+            const uint32_t stop = ~TMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + from)));
+            if(stop)
+                return from + std::countr_zero(stop);
+        }
+        while(from != size && TScalar(chars[from])) from++;
+        return from;
+    }
+
+    __attribute__((target("avx2"))) WhitespaceRun skipWhitespaceAvx2(const char* chars, size_t from, size_t size, size_t lineStart)
+    {
+        WhitespaceRun run {from, 0, lineStart};
+        for(; run.end + 32 <= size; run.end += 32)
+        {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + run.end));
+            const uint32_t stop = ~whitespaceMaskAvx2(v);
+            const uint32_t inRun = stop ? (1u << std::countr_zero(stop)) - 1 : 0xFFFFFFFF;
+            const uint32_t newLines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))) & inRun;
+
+            if(newLines)
+            {
+                run.newLines += std::popcount(newLines);
+                run.lastLineStart = run.end + 32 - std::countl_zero(newLines);
+            }
+            if(stop)
+                return WhitespaceRun {run.end + std::countr_zero(stop), run.newLines, run.lastLineStart};
+        }
+        const auto tail = skipWhitespaceScalar(chars, run.end, size, run.lastLineStart);
+        return WhitespaceRun {tail.end, run.newLines + tail.newLines, tail.lastLineStart};
+    }
+#endif
+
+    struct Implementation
+    {
+        LexSimd::Isa isa;
+        WhitespaceRun (*whitespace)(const char*, size_t, size_t, size_t);
+        size_t (*identifier)(const char*, size_t, size_t);
+        size_t (*digits)(const char*, size_t, size_t);
+    };
+
+    const Implementation& implementation()
+    {
+        static const Implementation selected = []() -> Implementation
+        {
+#ifdef QLANG_LEX_X86
+            if(__builtin_cpu_supports("avx2"))
+                return {LexSimd::Isa::Avx2, skipWhitespaceAvx2, skipAvx2<identifierMaskAvx2, isIdentifier>, skipAvx2<digitMaskAvx2, isDigit>};
+            return {LexSimd::Isa::Sse2, skipWhitespaceSse2, skipSse2<identifierMaskSse2, isIdentifier>, skipSse2<digitMaskSse2, isDigit>};
+#else
+            return {LexSimd::Isa::Scalar, skipWhitespaceScalar, skipIdentifierScalar, skipDigitsScalar};
+#endif
+        }();
+        return selected;
+    }
+}
+
+LexSimd::Isa LexSimd::selectedIsa()
+{
+    return implementation().isa;
+}
+
+LexSimd::WhitespaceRun LexSimd::skipWhitespace(const char* chars, size_t from, size_t size, size_t lineStart)
+{
+    return implementation().whitespace(chars, from, size, lineStart);
+}
+
+size_t LexSimd::skipIdentifier(const char* chars, size_t from, size_t size)
+{
+    return implementation().identifier(chars, from, size);
+}
+
+size_t LexSimd::skipDigits(const char* chars, size_t from, size_t size)
+{
+    return implementation().digits(chars, from, size);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+// Vectorized scanning of character runs for LexScanner.
+// Implementation (AVX2, SSE2 or scalar) is selected once at runtime from what CPU supports.
+// Functions never read at or past size, so input does not need padding.
+namespace LexSimd
+{
+    enum class Isa { Scalar, Sse2, Avx2 };
+    Isa selectedIsa();
+
+    struct WhitespaceRun
+    {
+        size_t end;             // first non whitespace position
+        size_t newLines;        // count of '\n' in the run
+        size_t lastLineStart;   // position after the last '\n' in the run, unchanged when none
+    };
+
+    // whitespace as isspace in "C" locale
+    WhitespaceRun skipWhitespace(const char* chars, size_t from, size_t size, size_t lineStart);
+    // [0-9A-Za-z_]
+    size_t skipIdentifier(const char* chars, size_t from, size_t size);
+    // [0-9]
+    size_t skipDigits(const char* chars, size_t from, size_t size);
+}
@@ -4,12 +4,68 @@
 
 std::string LexToken::Source::stringify() const
 {
-    return fromSource->name + ":" + std::to_string(atLine) + ":" + std::to_string(startingCharacter);
+    return CodeSourceRegistry::get(sourceId).name + ":" + std::to_string(atLine) + ":" + std::to_string(startingCharacter);
 }
 
 std::string LexToken::Source::printHint() const
 {
-    return fromSource->printHint(atLine, startingCharacter);
+    return CodeSourceRegistry::get(sourceId).printHint(atLine, startingCharacter);
+}
+
+LexToken::SeparatorKind LexToken::toSeparatorKind(std::string_view in)
+{
+    if(in == "+")  return SeparatorKind::Plus;
+    if(in == "-")  return SeparatorKind::Minus;
+    if(in == "*")  return SeparatorKind::Star;
+    if(in == "^")  return SeparatorKind::Caret;
+    if(in == "/")  return SeparatorKind::Slash;
+    if(in == "%")  return SeparatorKind::Percent;
+    if(in == "(")  return SeparatorKind::OpenParen;
+    if(in == ")")  return SeparatorKind::CloseParen;
+    if(in == "{")  return SeparatorKind::OpenBrace;
+    if(in == "}")  return SeparatorKind::CloseBrace;
+    if(in == "[")  return SeparatorKind::OpenBracket;
+    if(in == "]")  return SeparatorKind::CloseBracket;
+    if(in == "==") return SeparatorKind::EqualEqual;
+    if(in == "!=") return SeparatorKind::BangEqual;
+    if(in == "<")  return SeparatorKind::Less;
+    if(in == ">")  return SeparatorKind::Greater;
+    if(in == "<=") return SeparatorKind::LessEqual;
+    if(in == ">=") return SeparatorKind::GreaterEqual;
+    if(in == "!")  return SeparatorKind::Bang;
+    if(in == "&&") return SeparatorKind::AndAnd;
+    if(in == "||") return SeparatorKind::OrOr;
+    if(in == ":=") return SeparatorKind::ColonEqual;
+    if(in == ",")  return SeparatorKind::Comma;
+    if(in == "fn") return SeparatorKind::Fn;
+    return SeparatorKind::Unknown;
+}
+
+LexToken::Keyword LexToken::toKeyword(std::string_view in)
+{
+    switch(in.size())
+    {
+        case 2:
+            if(in == "if") return Keyword::If;
+            break;
+        case 3:
+            if(in == "for") return Keyword::For;
+            if(in == "ret") return Keyword::Ret;
+            break;
+        case 4:
+            if(in == "else") return Keyword::Else;
+            if(in == "pfor") return Keyword::Pfor;
+            if(in == "true") return Keyword::True;
+            break;
+        case 5:
+            if(in == "print") return Keyword::Print;
+            if(in == "while") return Keyword::While;
+            if(in == "false") return Keyword::False;
+            break;
+        default:
+            break;
+    }
+    return Keyword::None;
 }
 
 std::string LexToken::printHint(const Any& in)
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 
@@ -12,9 +14,9 @@ namespace  LexToken
 {
     struct Source
     {
-        std::shared_ptr<CodeSource> fromSource {};
-        size_t atLine {};
-        size_t startingCharacter {};
+        uint32_t sourceId {CodeSourceRegistry::NO_SOURCE};
+        uint32_t atLine {};
+        uint32_t startingCharacter {};
 
         std::string stringify() const;
         std::string printHint() const;
@@ -29,9 +31,29 @@ namespace  LexToken
         TContentType content {};
     };
 
-    struct Separator    final       : public WithContent<std::string> {};
-    struct Label        final       : public WithContent<std::string> {};
-    struct String       final       : public WithContent<std::string> {};
+    // classified once by scanner, so parser and interpreters can switch instead of comparing strings
+    enum class SeparatorKind : uint8_t
+    {
+        Unknown,
+        Plus, Minus, Star, Caret, Slash, Percent,
+        OpenParen, CloseParen, OpenBrace, CloseBrace, OpenBracket, CloseBracket,
+        EqualEqual, BangEqual, Less, Greater, LessEqual, GreaterEqual,
+        Bang, AndAnd, OrOr, ColonEqual, Comma, Fn,
+    };
+
+    enum class Keyword : uint8_t
+    {
+        None,
+        Print, If, Else, While, For, Pfor, Ret, True, False,
+    };
+
+    SeparatorKind toSeparatorKind(std::string_view in);
+    Keyword toKeyword(std::string_view in);
+
+    // text tokens borrow from CodeSource content, which stays alive while source is registered
+    struct Separator    final       : public WithContent<std::string_view> { SeparatorKind kind {}; };
+    struct Label        final       : public WithContent<std::string_view> { Keyword keyword {}; };
+    struct String       final       : public WithContent<std::string_view> {};
     struct Integer      final       : public WithContent<int>         {};
     struct Float        final       : public WithContent<float>       {};
 
@@ -0,0 +1,64 @@
+#include "LexTokenBuffer.hpp"
+
+#include <bit>
+#include <vx.hpp>
+
+LexTokenBuffer::LexTokenBuffer(LexScanner& scanner)
+:   source(scanner.getSource()),
+    sourceId(scanner.getSourceId())
+{
+    while(auto token = scanner.current())
+    {
+        push(*token);
+        scanner.next();
+    }
+}
+
+void LexTokenBuffer::push(const LexToken::Any& token)
+{
+    const auto addText = [this](std::string_view content)
+    {
+        offsets.push_back(static_cast<uint32_t>(content.data() - source->text().data()));
+        lengths.push_back(static_cast<uint32_t>(content.size()));
+    };
+    const auto addNumber = [this]()
+    {
+        offsets.push_back(0);
+        lengths.push_back(0);
+    };
+
+    token |vx::match {
+        [&](const LexToken::Separator& v)   { addText(v.content); payloads.push_back(static_cast<uint32_t>(v.kind)); },
+        [&](const LexToken::Label& v)       { addText(v.content); payloads.push_back(static_cast<uint32_t>(v.keyword)); },
+        [&](const LexToken::String& v)      { addText(v.content); payloads.push_back(0); },
+        [&](const LexToken::Integer& v)     { addNumber(); payloads.push_back(std::bit_cast<uint32_t>(v.content)); },
+        [&](const LexToken::Float& v)       { addNumber(); payloads.push_back(std::bit_cast<uint32_t>(v.content)); },
+    };
+
+    std::visit([this](auto& v)
+    {
+        lines.push_back(v.source.atLine);
+        characters.push_back(v.source.startingCharacter);
+    },token);
+    kinds.push_back(static_cast<Kind>(token.index()));
+}
+
+LexToken::Any LexTokenBuffer::at(size_t idx) const
+{
+    const LexToken::Source tokenSource {
+        .sourceId = sourceId,
+        .atLine = lines[idx],
+        .startingCharacter = characters[idx],
+    };
+    const auto text = source->text().substr(offsets[idx], lengths[idx]);
+
+    switch(kinds[idx])
+    {
+        case Kind::Separator:   return LexToken::Separator{tokenSource, text, static_cast<LexToken::SeparatorKind>(payloads[idx])};
+        case Kind::Label:       return LexToken::Label{tokenSource, text, static_cast<LexToken::Keyword>(payloads[idx])};
+        case Kind::String:      return LexToken::String{tokenSource, text};
+        case Kind::Integer:     return LexToken::Integer{tokenSource, std::bit_cast<int>(payloads[idx])};
+        case Kind::Float:       return LexToken::Float{tokenSource, std::bit_cast<float>(payloads[idx])};
+    }
+    return LexToken::Integer{tokenSource};
+}
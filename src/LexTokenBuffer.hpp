@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "LexScanner.hpp"
+#include "LexToken.hpp"
+
+// Whole CodeSource tokenized in one pass, kept as structure of arrays.
+// Walked by parser with the same current/next interface as LexScanner, plus lookahead.
+class LexTokenBuffer
+{
+public:
+    // same order as alternatives of LexToken::Any
+    enum class Kind : uint8_t { Separator, Label, String, Integer, Float };
+
+    // drains scanner from its current token to the end
+    explicit LexTokenBuffer(LexScanner& scanner);
+
+    size_t size() const { return kinds.size(); }
+    LexToken::Any at(size_t idx) const;
+
+    template<typename T>
+    std::optional<T> at(size_t idx) const
+    {
+        if(idx >= kinds.size() || kinds[idx] != kindOf<T>())
+            return {};
+        return std::get<T>(at(idx));
+    }
+
+    std::optional<LexToken::Any> peek(size_t ahead) const
+    {
+        if(positionIdx + ahead >= kinds.size())
+            return {};
+        return at(positionIdx + ahead);
+    }
+
+    template<typename T>
+    std::optional<T> peek(size_t ahead) const { return at<T>(positionIdx + ahead); }
+
+    std::optional<LexToken::Any> current() const { return peek(0); }
+
+    template<typename T>
+    std::optional<T> current() const { return peek<T>(0); }
+
+    std::optional<LexToken::Separator> currentMath(LexToken::SeparatorKind expected) const
+    {
+        if(positionIdx < kinds.size() && kinds[positionIdx] == Kind::Separator && static_cast<LexToken::SeparatorKind>(payloads[positionIdx]) == expected)
+            return current<LexToken::Separator>();
+        return {};
+    }
+
+    std::optional<LexToken::Separator> peekMath(size_t ahead, LexToken::SeparatorKind expected) const
+    {
+        const size_t idx = positionIdx + ahead;
+        if(idx < kinds.size() && kinds[idx] == Kind::Separator && static_cast<LexToken::SeparatorKind>(payloads[idx]) == expected)
+            return peek<LexToken::Separator>(ahead);
+        return {};
+    }
+
+    std::optional<LexToken::Label> currentMath(LexToken::Keyword expected) const
+    {
+        if(positionIdx < kinds.size() && kinds[positionIdx] == Kind::Label && static_cast<LexToken::Keyword>(payloads[positionIdx]) == expected)
+            return current<LexToken::Label>();
+        return {};
+    }
+
+    std::optional<LexToken::Any> next()
+    {
+        if(positionIdx < kinds.size())
+            positionIdx++;
+        return current();
+    }
+
+    void restart() { positionIdx = 0; }
+
+protected:
+    template<typename T>
+    static constexpr Kind kindOf()
+    {
+        if constexpr (std::is_same_v<T, LexToken::Separator>)   return Kind::Separator;
+        else if constexpr (std::is_same_v<T, LexToken::Label>)  return Kind::Label;
+        else if constexpr (std::is_same_v<T, LexToken::String>) return Kind::String;
+        else if constexpr (std::is_same_v<T, LexToken::Integer>) return Kind::Integer;
+        else
+        {
+            static_assert(std::is_same_v<T, LexToken::Float>);
+            return Kind::Float;
+        }
+    }
+
+    void push(const LexToken::Any& token);
+
+    std::shared_ptr<CodeSource> source;
+    uint32_t sourceId;
+    size_t positionIdx {0};
+
+    std::vector<Kind> kinds {};
+    std::vector<uint32_t> offsets {};   // text tokens: start of content in source
+    std::vector<uint32_t> lengths {};   // text tokens: content size, 0 for numbers
+    std::vector<uint32_t> payloads {};  // SeparatorKind, Keyword, or bits of Integer/Float value
+    std::vector<uint32_t> lines {};
+    std::vector<uint32_t> characters {};
+};
@@ -0,0 +1,70 @@
+#include "OutputSink.hpp"
+
+#include <cstdio>
+
+#if __has_include(<unistd.h>)
+#include <cerrno>
+#include <unistd.h>
+#define QLANG_HAS_POSIX_WRITE 1
+#endif
+
+FileOutputSink::FileOutputSink(int inFd, size_t inCapacity) : fd(inFd), capacity(inCapacity)
+{
+    buffer.reserve(capacity);
+}
+
+FileOutputSink::~FileOutputSink()
+{
+    flush();
+}
+
+void FileOutputSink::write(std::string_view text)
+{
+    if(buffer.size() + text.size() > capacity)
+        flush();
+    buffer += text;
+    if(buffer.size() >= capacity) // text larger than whole buffer
+        flush();
+}
+
+void FileOutputSink::flush()
+{
+#ifdef QLANG_HAS_POSIX_WRITE
+    size_t written = 0;
+    while(written != buffer.size())
+    {
+        const auto result = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0) // nothing more can be done about closed or broken output
+            break;
+        written += static_cast<size_t>(result);
+    }
+#else
+    std::fwrite(buffer.data(), 1, buffer.size(), fd == 2 ? stderr : stdout);
+    std::fflush(fd == 2 ? stderr : stdout);
+#endif
+    buffer.clear();
+}
+
+OutputSinkStreamBuf::int_type OutputSinkStreamBuf::overflow(int_type ch)
+{
+    if(traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+
+    const char asChar = traits_type::to_char_type(ch);
+    sink.write(std::string_view(&asChar, 1));
+    return ch;
+}
+
+std::streamsize OutputSinkStreamBuf::xsputn(const char* text, std::streamsize count)
+{
+    sink.write(std::string_view(text, static_cast<size_t>(count)));
+    return count;
+}
+
+int OutputSinkStreamBuf::sync()
+{
+    sink.flush();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+// Destination of values printed by PrintStmt.
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+
+    virtual void write(std::string_view text) = 0;
+    virtual void flush() {};
+};
+
+// Collects output in one large buffer handed to file descriptor with write(2) when full or flushed.
+class FileOutputSink final : public OutputSink
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit FileOutputSink(int inFd, size_t inCapacity = DEFAULT_CAPACITY);
+    ~FileOutputSink() override;
+
+    FileOutputSink(const FileOutputSink&) = delete;
+    FileOutputSink& operator=(const FileOutputSink&) = delete;
+
+    void write(std::string_view text) override;
+    void flush() override;
+
+protected:
+    int fd;
+    size_t capacity;
+    std::string buffer {};
+};
+
+// Keeps output in memory, for embedders which want it as a string.
+class StringOutputSink final : public OutputSink
+{
+public:
+    void write(std::string_view text) override { content += text; }
+
+    std::string content {};
+};
+
+// std::streambuf writing into sink, set as std::cout buffer keeps diagnostics in order with printed values
+class OutputSinkStreamBuf final : public std::streambuf
+{
+public:
+    explicit OutputSinkStreamBuf(OutputSink& inSink) : sink(inSink) {};
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* text, std::streamsize count) override;
+    int sync() override;
+
+    OutputSink& sink;
+};
@@ -0,0 +1,56 @@
+#include "ParallelFor.hpp"
+
+std::optional<TemporaryValue::Any> parallelReduce(LexToken::SeparatorKind reduce, const TemporaryValue::Any& acc, const TemporaryValue::Any& value)
+{
+    switch(reduce)
+    {
+        case LexToken::SeparatorKind::Plus:     return TemporaryValue::binaryOp(TemporaryValue::BinaryOperator::Add, acc, value);
+        case LexToken::SeparatorKind::Star:     return TemporaryValue::binaryOp(TemporaryValue::BinaryOperator::Multiply, acc, value);
+        case LexToken::SeparatorKind::AndAnd:
+        case LexToken::SeparatorKind::OrOr:
+        {
+            if(!acc.is<TemporaryValue::Bool>() || !value.is<TemporaryValue::Bool>())
+                return std::nullopt;
+            const bool left = acc.as<TemporaryValue::Bool>().value;
+            const bool right = value.as<TemporaryValue::Bool>().value;
+            return TemporaryValue::Bool{reduce == LexToken::SeparatorKind::AndAnd ? left && right : left || right};
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+TemporaryValue::Any parallelIdentity(LexToken::SeparatorKind reduce)
+{
+    switch(reduce)
+    {
+        case LexToken::SeparatorKind::Plus:     return TemporaryValue::Integer{0};
+        case LexToken::SeparatorKind::Star:     return TemporaryValue::Integer{1};
+        case LexToken::SeparatorKind::AndAnd:   return TemporaryValue::Bool{true};
+        default:                                return TemporaryValue::Bool{false};
+    }
+}
+
+void ParallelForDetail::combine(const AstNode::ParallelFor& loop, std::optional<TemporaryValue::Any>& acc, TemporaryValue::Any value)
+{
+    if(!acc)
+    {
+        acc = std::move(value);
+        return;
+    }
+    if(auto combined = parallelReduce(loop.reduce->kind, *acc, value))
+    {
+        acc = std::move(*combined);
+        return;
+    }
+    diagnostics() << "unsupported reduction:'" << loop.reduce->content << "' between left:'" << *acc << "' and right:'" << value << "'\n";
+    diagnostics() << loop.reduce->source.printHint() << "here \n";
+    throw std::runtime_error("");
+}
+
+void ParallelForDetail::budgetExhausted(const AstNode::ParallelFor& loop, const RuntimeContext& worker)
+{
+    diagnostics() << "budget exhausted: " << worker.exhaustedReason() << "\n";
+    diagnostics() << loop.tokenValue.source.printHint() << "here \n";
+    throw BudgetExhausted();
+}
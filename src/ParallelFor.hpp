@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "AstNode.hpp"
+#include "Diagnostics.hpp"
+#include "OutputSink.hpp"
+#include "RuntimeScope.hpp"
+#include "TemporaryValue.hpp"
+#include "WorkStealingPool.hpp"
+
+// Iterations of a ParallelFor are cut into at most MAX_PARALLEL_BLOCKS blocks of consecutive indices, depending only on the range.
+// Blocks run on WorkStealingPool::shared() and their values, printed output and errors are combined in order of blocks,
+// so a run gives the same result as running the iterations one by one, whatever the number of threads.
+constexpr size_t MAX_PARALLEL_BLOCKS = 1024;
+
+// combines value of the next iteration into acc, nullopt when reduction does not support the values
+std::optional<TemporaryValue::Any> parallelReduce(LexToken::SeparatorKind reduce, const TemporaryValue::Any& acc, const TemporaryValue::Any& value);
+// value of reduction over empty range
+TemporaryValue::Any parallelIdentity(LexToken::SeparatorKind reduce);
+
+namespace ParallelForDetail
+{
+    // appends to the output of the block its worker runs
+    class BlockOutputSink final : public OutputSink
+    {
+    public:
+        void write(std::string_view text) override { target->append(text); }
+
+        std::string* target {};
+    };
+
+    struct BlockResult
+    {
+        std::optional<TemporaryValue::Any> value {};
+        std::string output {};
+        std::string error {};
+        bool failed {false};
+        bool exhausted {false};
+    };
+
+    // state of one participant, functions it calls share global scope of the loop's context read only,
+    // an assignment to a global fails as no worker may write what others read
+    template<typename Runner>
+    struct Worker
+    {
+        template<typename MakeRunner>
+        Worker(RuntimeContext& parent, SharedFuel& fuel, MakeRunner& makeRunner)
+            : context(parent.globalScope, output, parent.workerBudget()), runner(makeRunner(context))
+        {
+            context.sharedFuel = &fuel;
+            context.sharedGlobals = true;
+        }
+
+        BlockOutputSink output {};
+        std::ostringstream messages {};
+        RuntimeContext context;
+        Runner runner;
+    };
+
+    void combine(const AstNode::ParallelFor& loop, std::optional<TemporaryValue::Any>& acc, TemporaryValue::Any value);
+    [[noreturn]] void budgetExhausted(const AstNode::ParallelFor& loop, const RuntimeContext& worker);
+}
+
+// runs loop in enclosing scope of context, makeRunner(RuntimeContext& worker) gives a callable running the body of one iteration
+// in scope of the worker, which is called only from the worker's thread
+template<typename MakeRunner>
+TemporaryValue::Any runParallelFor(const AstNode::ParallelFor& loop, RuntimeContext& context, RuntimeScope& enclosing,
+    const TemporaryValue::Any& beginValue, const TemporaryValue::Any& endValue, MakeRunner makeRunner)
+{
+    using namespace ParallelForDetail;
+    using Runner = std::invoke_result_t<MakeRunner&, RuntimeContext&>;
+
+    if(!beginValue.is<TemporaryValue::Integer>() || !endValue.is<TemporaryValue::Integer>())
+    {
+        diagnostics() << "pfor range must be integers, begin:'" << beginValue << "' end:'" << endValue << "'\n";
+        diagnostics() << loop.tokenValue.source.printHint() << "here \n";
+        throw std::runtime_error("");
+    }
+    const int64_t begin = beginValue.as<TemporaryValue::Integer>().value;
+    const int64_t end = endValue.as<TemporaryValue::Integer>().value;
+    const uint64_t count = end > begin ? static_cast<uint64_t>(end - begin) : 0;
+    const size_t blocks = static_cast<size_t>(std::min<uint64_t>(count, MAX_PARALLEL_BLOCKS));
+    const uint32_t indexSlot = static_cast<const AstNode::Identifier*>(loop.index)->slot;
+
+    auto& pool = WorkStealingPool::shared();
+    std::vector<BlockResult> results(blocks);
+    std::vector<std::unique_ptr<Worker<Runner>>> workers(pool.participants());
+    std::atomic<size_t> firstFailed {blocks}; // blocks after it are skipped, the ones before still run so the reported error is the first one
+    SharedFuel fuel(context.takeFuel(), context.sharedFuel);
+
+    pool.run(blocks, [&](size_t participant, size_t block)
+    {
+        if(block > firstFailed.load(std::memory_order_relaxed))
+            return;
+
+        auto& result = results[block];
+        try
+        {
+            auto& worker = workers[participant];
+            if(!worker)
+                worker = std::make_unique<Worker<Runner>>(context, fuel, makeRunner);
+            worker->output.target = &result.output;
+
+            DiagnosticsRedirect redirect(worker->messages);
+            try
+            {
+                for(uint64_t i = count * block / blocks; i != count * (block+1) / blocks; i++)
+                {
+                    if(!worker->context.consumeFuel()) [[unlikely]]
+                        budgetExhausted(loop, worker->context);
+
+                    auto& scope = worker->context.pushScope(enclosing, loop.scopeSize);
+                    scope.slots[indexSlot] = TemporaryValue::Integer{static_cast<int>(begin + static_cast<int64_t>(i))};
+                    auto value = worker->runner(scope);
+                    worker->context.popScope();
+
+                    if(loop.reduce)
+                        combine(loop, result.value, std::move(value));
+                }
+                return;
+            }
+            catch(BudgetExhausted&)
+            {
+                result.exhausted = true;
+            }
+            catch(std::exception&)
+            {
+            }
+            result.error = worker->messages.str();
+            worker->messages.str({});
+            worker->context.frames.clear();
+            worker->context.scopes.clear();
+        }
+        catch(std::exception&) // worker could not be created
+        {
+        }
+        result.failed = true;
+
+        auto current = firstFailed.load(std::memory_order_relaxed);
+        while(block < current && !firstFailed.compare_exchange_weak(current, block, std::memory_order_relaxed));
+    });
+
+    for(auto& it : workers)
+    {
+        if(it)
+            fuel.give(it->context.remainingFuel());
+    }
+    context.giveFuel(fuel.remaining.load(std::memory_order_relaxed));
+
+    std::optional<TemporaryValue::Any> acc;
+    for(auto& it : results)
+    {
+        context.output.write(it.output);
+        if(it.failed)
+        {
+            diagnostics() << it.error;
+            if(it.exhausted)
+                throw BudgetExhausted();
+            throw std::runtime_error("");
+        }
+        if(loop.reduce && it.value)
+            combine(loop, acc, std::move(*it.value));
+    }
+
+    if(!loop.reduce)
+        return TemporaryValue::Bool{false};
+    return acc ? std::move(*acc) : parallelIdentity(loop.reduce->kind);
+}
@@ -0,0 +1,112 @@
+#include "QLang.hpp"
+
+#include "AstOptimizer.hpp"
+#include "AstParser.hpp"
+#include "AstTreeWalkInterpreter.hpp"
+#include "ByteCodeCompiler.hpp"
+#include "Diagnostics.hpp"
+#include "LexScanner.hpp"
+#include "LexTokenBuffer.hpp"
+#include "ScriptRunner.hpp"
+
+std::shared_ptr<const QLang::Program> QLang::Program::compile(std::string name, std::string source, CompileOptions options)
+{
+    return compile(std::make_shared<CodeSource>(std::move(name), std::move(source)), options);
+}
+
+std::shared_ptr<const QLang::Program> QLang::Program::compile(std::shared_ptr<CodeSource> source, CompileOptions options)
+{
+    std::shared_ptr<Program> program(new Program(options));
+    program->source = source;
+    std::ostringstream messages;
+    try
+    {
+        DiagnosticsRedirect redirect(messages);
+
+        LexScanner scanner(std::move(source), SEPARATORS);
+        program->sourceId = scanner.getSourceId();
+        LexTokenBuffer tokens(scanner);
+
+        program->root = AstParser(tokens, program->arena).block();
+        if(options.optimize)
+            program->root = AstOptimizer(program->arena).optimize(program->root);
+        program->resolver.resolve(program->root);
+
+        if(options.backend == Backend::Vm)
+            program->chunk = ByteCodeCompiler().compile(program->root);
+    }
+    catch(std::runtime_error&)
+    {
+        throw CompileError(messages.str());
+    }
+    return program;
+}
+
+QLang::Program::~Program()
+{
+    CodeSourceRegistry::release(sourceId);
+}
+
+QLang::Context::Context(std::shared_ptr<const Program> inProgram, OutputSink* inOutput)
+    : shared(std::move(inProgram)),
+      sink(inOutput ? *inOutput : collected),
+      inputs(nullptr, shared->globalCount()),
+      global(nullptr, shared->globalCount()),
+      context(global, sink),
+      vm(context)
+{
+}
+
+bool QLang::Context::set(std::string_view name, TemporaryValue::Any value)
+{
+    const auto slot = shared->globalSlot(name);
+    if(!slot)
+        return false;
+    inputs.slots[*slot] = std::move(value);
+    return true;
+}
+
+void QLang::Context::clearInputs()
+{
+    for(auto& it : inputs.slots)
+        it.reset();
+}
+
+std::optional<TemporaryValue::Any> QLang::Context::get(std::string_view name) const
+{
+    if(auto slot = shared->globalSlot(name))
+        return global.slots[*slot];
+    return std::nullopt;
+}
+
+QLang::RunResult QLang::Context::run()
+{
+    RuntimeBudget budget {.fuel = fuel};
+    if(timeout)
+        budget.deadline = std::chrono::steady_clock::now() + *timeout;
+    context.restart(budget);
+    global.slots = inputs.slots; // reuses capacity, strings and functions are shared
+
+    RunResult result;
+    messages.str({});
+    try
+    {
+        DiagnosticsRedirect redirect(messages);
+        auto value = shared->backend() == Backend::Vm
+            ? vm.run(shared->chunk)
+            : treeWallInterpret(shared->root, context, global, true);
+        result.value = context.completedNormally() ? std::move(value) : context.returnValue;
+    }
+    catch(BudgetExhausted&)
+    {
+        result.status = RunResult::Status::Exhausted;
+        result.error = messages.str();
+    }
+    catch(std::runtime_error&)
+    {
+        result.status = RunResult::Status::Error;
+        result.error = messages.str();
+    }
+    sink.flush();
+    return result;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "AstNode.hpp"
+#include "AstResolver.hpp"
+#include "ByteCode.hpp"
+#include "ByteCodeVm.hpp"
+#include "CodeSource.hpp"
+#include "OutputSink.hpp"
+#include "RuntimeScope.hpp"
+#include "TemporaryValue.hpp"
+
+// Embedding api: source is compiled once into Program, which any number of Contexts run many times with different inputs.
+//
+//   auto program = QLang::Program::compile("rule", "ret price * count");
+//   QLang::Context context(program);
+//   context.set("price", TemporaryValue::Float{2.5f});
+//   context.set("count", TemporaryValue::Integer{4});
+//   auto result = context.run();   // result.value is Float{10}
+//
+// Inputs are global variables the script reads without assigning them first.
+//
+// Program is immutable once compiled apart from quickening state, which is atomic, and bytecode of functions compiled on first call,
+// which is published once (FuncBody::compiledAs), so Contexts on different threads may share it.
+// Their runs still meet on refcounts of the program's constants, a thread which should not share anything runs an Isolate.
+// pfor loops of all Contexts run on one process wide WorkStealingPool, loops of concurrent runs share its threads
+// and the thread calling run always works on its own loop.
+namespace QLang
+{
+    enum class Backend : uint8_t { TreeWalk, Vm };
+
+    struct CompileOptions
+    {
+        Backend backend {Backend::Vm};
+        bool optimize {true};
+    };
+
+    // thrown by Program::compile, what() holds the messages printed by lexer, parser or resolver
+    struct CompileError : public std::runtime_error
+    {
+        explicit CompileError(const std::string& diagnostics) : std::runtime_error(diagnostics) {};
+    };
+
+    // Lexed, parsed, optimized, resolved and (for Backend::Vm) compiled source.
+    class Program
+    {
+    public:
+        static std::shared_ptr<const Program> compile(std::string name, std::string source, CompileOptions options = {});
+        // source must not change afterwards, clone() lexes it again
+        static std::shared_ptr<const Program> compile(std::shared_ptr<CodeSource> source, CompileOptions options = {});
+
+        // compiles the same source again, the copy shares only the immutable source text
+        std::shared_ptr<const Program> clone() const { return compile(source, options); }
+
+        ~Program();
+
+        Program(const Program&) = delete;
+        Program& operator=(const Program&) = delete;
+
+        Backend backend() const { return options.backend; }
+
+        // slot of global variable name, nullopt when the script never refers to it
+        std::optional<uint32_t> globalSlot(std::string_view name) const { return resolver.globalSlot(name); }
+        size_t globalCount() const { return resolver.globalCount(); }
+
+    protected:
+        friend class Context;
+
+        explicit Program(CompileOptions inOptions) : options(inOptions) {};
+
+        CompileOptions options;
+        std::shared_ptr<CodeSource> source {};
+        uint32_t sourceId {CodeSourceRegistry::NO_SOURCE};
+        AstNode::Arena arena {};
+        AstNode::NodePtr root {};
+        AstResolver resolver {};
+        ByteCode::Chunk chunk {}; // only for Backend::Vm
+    };
+
+    struct RunResult
+    {
+        enum class Status : uint8_t { Ok, Error, Exhausted };
+
+        bool ok() const { return status == Status::Ok; }
+
+        Status status {Status::Ok};
+        TemporaryValue::Any value {};   // value of top level 'ret', otherwise of the last statement
+        std::string error {};           // messages printed by the failed run
+    };
+
+    // Globals, output and budget of runs of one program. Every run starts from globals holding only the inputs set so far,
+    // scopes and stacks are reused, so repeated runs do not allocate once they have grown.
+    // Func values taken out of the context refer to the program and must not outlive it.
+    class Context
+    {
+    public:
+        // printed values go to output, or are collected into output() when it is null
+        explicit Context(std::shared_ptr<const Program> inProgram, OutputSink* inOutput = nullptr);
+
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+
+        // sets input kept for every following run, false when the script never refers to name
+        bool set(std::string_view name, TemporaryValue::Any value);
+        void clearInputs();
+
+        // global variable after the last run, nullopt when it is unknown or was not assigned
+        std::optional<TemporaryValue::Any> get(std::string_view name) const;
+
+        void setFuel(uint64_t inFuel) { fuel = inFuel; }
+        void setTimeout(std::optional<std::chrono::milliseconds> inTimeout) { timeout = inTimeout; }
+
+        RunResult run();
+
+        // output of runs since the last call of clearOutput(), empty when the context prints into external sink
+        const std::string& output() const { return collected.content; }
+        void clearOutput() { collected.content.clear(); }
+
+        const Program& program() const { return *shared; }
+
+    protected:
+        std::shared_ptr<const Program> shared;
+        StringOutputSink collected {};
+        OutputSink& sink;
+        std::ostringstream messages {}; // diagnostics of the current run
+
+        RuntimeScope inputs;
+        RuntimeScope global;
+        RuntimeContext context;
+        ByteCodeVm vm;
+
+        uint64_t fuel {RuntimeBudget::DEFAULT_FUEL};
+        std::optional<std::chrono::milliseconds> timeout {};
+    };
+
+    // Context running a private clone of the program, so its runs write only to memory of this isolate.
+    // One isolate per thread runs without locks or contended atomics, see Program.
+    class Isolate : public Context
+    {
+    public:
+        explicit Isolate(const Program& inProgram, OutputSink* inOutput = nullptr) : Context(inProgram.clone(), inOutput) {};
+    };
+}
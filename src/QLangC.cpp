@@ -0,0 +1,225 @@
+#include "QLangC.h"
+
+#include "QLang.hpp"
+
+// exceptions must not cross the C boundary, every entry which may throw catches them
+struct qlang_program
+{
+    std::shared_ptr<const QLang::Program> program;
+};
+
+struct qlang_context
+{
+    explicit qlang_context(std::shared_ptr<const QLang::Program> program) : context(std::move(program)) {};
+
+    QLang::Context context;
+    QLang::RunResult result {};
+    std::string resultString {};
+};
+
+namespace
+{
+    thread_local std::string compileError;
+
+    int setInput(qlang_context* context, const char* name, TemporaryValue::Any value)
+    {
+        return context->context.set(name, std::move(value)) ? 1 : 0;
+    }
+}
+
+qlang_program* qlang_compile(const char* name, const char* source, int use_vm)
+{
+    try
+    {
+        const QLang::CompileOptions options {.backend = use_vm ? QLang::Backend::Vm : QLang::Backend::TreeWalk};
+        return new qlang_program{QLang::Program::compile(name ? name : "", source ? source : "", options)};
+    }
+    catch(std::exception& e)
+    {
+        compileError = e.what();
+        return nullptr;
+    }
+}
+
+const char* qlang_compile_error(void)
+{
+    return compileError.c_str();
+}
+
+void qlang_program_free(qlang_program* program)
+{
+    delete program;
+}
+
+qlang_context* qlang_context_new(const qlang_program* program)
+{
+    try
+    {
+        return new qlang_context(program->program);
+    }
+    catch(std::exception&)
+    {
+        return nullptr;
+    }
+}
+
+qlang_context* qlang_isolate_new(const qlang_program* program)
+{
+    try
+    {
+        return new qlang_context(program->program->clone());
+    }
+    catch(std::exception&)
+    {
+        return nullptr;
+    }
+}
+
+void qlang_context_free(qlang_context* context)
+{
+    delete context;
+}
+
+int qlang_set_bool(qlang_context* context, const char* name, int value)
+{
+    return setInput(context, name, TemporaryValue::Bool{value != 0});
+}
+
+int qlang_set_integer(qlang_context* context, const char* name, int value)
+{
+    return setInput(context, name, TemporaryValue::Integer{value});
+}
+
+int qlang_set_float(qlang_context* context, const char* name, float value)
+{
+    return setInput(context, name, TemporaryValue::Float{value});
+}
+
+int qlang_set_string(qlang_context* context, const char* name, const char* value)
+{
+    try
+    {
+        return setInput(context, name, TemporaryValue::String{value ? value : ""});
+    }
+    catch(std::exception&)
+    {
+        return 0;
+    }
+}
+
+int qlang_set_array(qlang_context* context, const char* name, const float* values, size_t size)
+{
+    if(size > TemporaryValue::MAX_ARRAY_SIZE)
+        return 0;
+    try
+    {
+        return setInput(context, name, TemporaryValue::Array{std::vector<float>(values, values + size)});
+    }
+    catch(std::exception&)
+    {
+        return 0;
+    }
+}
+
+void qlang_clear_inputs(qlang_context* context)
+{
+    context->context.clearInputs();
+}
+
+void qlang_set_fuel(qlang_context* context, uint64_t fuel)
+{
+    context->context.setFuel(fuel);
+}
+
+void qlang_set_timeout_ms(qlang_context* context, uint64_t milliseconds)
+{
+    if(milliseconds == 0)
+        context->context.setTimeout(std::nullopt);
+    else
+        context->context.setTimeout(std::chrono::milliseconds(milliseconds));
+}
+
+qlang_status qlang_run(qlang_context* context)
+{
+    context->context.clearOutput();
+    try
+    {
+        context->result = context->context.run();
+    }
+    catch(std::exception& e)
+    {
+        context->result = QLang::RunResult{.status = QLang::RunResult::Status::Error, .error = e.what()};
+    }
+
+    switch(context->result.status)
+    {
+        case QLang::RunResult::Status::Ok:          return QLANG_OK;
+        case QLang::RunResult::Status::Exhausted:   return QLANG_EXHAUSTED;
+        case QLang::RunResult::Status::Error:       break;
+    }
+    return QLANG_ERROR;
+}
+
+qlang_type qlang_result_type(const qlang_context* context)
+{
+    return static_cast<qlang_type>(context->result.value.getTag());
+}
+
+int qlang_result_bool(const qlang_context* context)
+{
+    const auto& value = context->result.value;
+    return value.is<TemporaryValue::Bool>() && value.as<TemporaryValue::Bool>().value ? 1 : 0;
+}
+
+int qlang_result_integer(const qlang_context* context)
+{
+    const auto& value = context->result.value;
+    if(value.is<TemporaryValue::Integer>() || value.is<TemporaryValue::Float>())
+        return TemporaryValue::getInteger(value);
+    return 0;
+}
+
+float qlang_result_float(const qlang_context* context)
+{
+    const auto& value = context->result.value;
+    if(value.is<TemporaryValue::Integer>() || value.is<TemporaryValue::Float>())
+        return TemporaryValue::getFloat(value);
+    return 0;
+}
+
+const float* qlang_result_array(const qlang_context* context, size_t* size)
+{
+    const auto& value = context->result.value;
+    if(!value.is<TemporaryValue::Array>())
+    {
+        *size = 0;
+        return nullptr;
+    }
+    *size = value.as<TemporaryValue::Array>().value.size();
+    return value.as<TemporaryValue::Array>().value.data();
+}
+
+const char* qlang_result_string(qlang_context* context)
+{
+    try
+    {
+        StringOutputSink printed;
+        TemporaryValue::print(printed, context->result.value);
+        context->resultString = std::move(printed.content);
+        return context->resultString.c_str();
+    }
+    catch(std::exception&)
+    {
+        return "";
+    }
+}
+
+const char* qlang_output(const qlang_context* context)
+{
+    return context->context.output().c_str();
+}
+
+const char* qlang_error(const qlang_context* context)
+{
+    return context->result.error.c_str();
+}
@@ -0,0 +1,80 @@
+#ifndef QLANG_C_H
+#define QLANG_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* C binding of the embedding api from QLang.hpp: compile once with qlang_compile, run many times with qlang_run. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct qlang_program qlang_program;
+typedef struct qlang_context qlang_context;
+
+typedef enum
+{
+    QLANG_OK = 0,
+    QLANG_ERROR = 1,            /* script error, message in qlang_error() */
+    QLANG_EXHAUSTED = 2         /* out of fuel or past timeout, message in qlang_error() */
+} qlang_status;
+
+typedef enum
+{
+    QLANG_BOOL = 0,
+    QLANG_INTEGER = 1,
+    QLANG_FLOAT = 2,
+    QLANG_STRING = 3,
+    QLANG_FUNC = 4,
+    QLANG_ARRAY = 5
+} qlang_type;
+
+/* NULL on error, then qlang_compile_error() describes it; use_vm selects the bytecode backend over the tree walker */
+qlang_program* qlang_compile(const char* name, const char* source, int use_vm);
+/* messages of the last failed qlang_compile on the calling thread */
+const char* qlang_compile_error(void);
+/* contexts keep their program alive, so it may be freed before them */
+void qlang_program_free(qlang_program* program);
+
+/* contexts of one program may run on different threads, each thread using its own context */
+qlang_context* qlang_context_new(const qlang_program* program);
+/* context over a private copy of the program, shares no memory written while running with other contexts */
+qlang_context* qlang_isolate_new(const qlang_program* program);
+void qlang_context_free(qlang_context* context);
+
+/* inputs are kept for every following run, return 0 when the script never refers to name or value could not be stored */
+int qlang_set_bool(qlang_context* context, const char* name, int value);
+int qlang_set_integer(qlang_context* context, const char* name, int value);
+int qlang_set_float(qlang_context* context, const char* name, float value);
+int qlang_set_string(qlang_context* context, const char* name, const char* value);
+/* copies size floats, returns 0 as well when size exceeds the longest array scripts may create */
+int qlang_set_array(qlang_context* context, const char* name, const float* values, size_t size);
+void qlang_clear_inputs(qlang_context* context);
+
+void qlang_set_fuel(qlang_context* context, uint64_t fuel);
+/* 0 disables the timeout */
+void qlang_set_timeout_ms(qlang_context* context, uint64_t milliseconds);
+
+qlang_status qlang_run(qlang_context* context);
+
+/* value of top level 'ret', otherwise of the last statement, of the last run;
+   integer and float convert into each other, other mismatched types give 0 */
+qlang_type qlang_result_type(const qlang_context* context);
+int qlang_result_bool(const qlang_context* context);
+int qlang_result_integer(const qlang_context* context);
+float qlang_result_float(const qlang_context* context);
+/* elements of an array result and their count in size, NULL with size 0 for other types; valid until the next run */
+const float* qlang_result_array(const qlang_context* context, size_t* size);
+/* any type printed as string, valid until the next run, empty when it could not be allocated */
+const char* qlang_result_string(qlang_context* context);
+
+/* printed output of the last run and messages of its error, valid until the next run */
+const char* qlang_output(const qlang_context* context);
+const char* qlang_error(const qlang_context* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
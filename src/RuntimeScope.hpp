@@ -1,27 +1,209 @@
 #pragma once
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include "OutputSink.hpp"
 #include "TemporaryValue.hpp"
 
+const int MAX_CALL_DEPTH = 1000;
+
+// Bounds work of one execution: every loop iteration and every call takes one unit of fuel,
+// deadline is compared with the clock once per DEADLINE_CHECK_INTERVAL units.
+struct RuntimeBudget
+{
+    static constexpr uint64_t DEFAULT_FUEL = 10'000'000;
+    static constexpr uint64_t DEADLINE_CHECK_INTERVAL = 1024;
+
+    uint64_t fuel {DEFAULT_FUEL};
+    std::optional<std::chrono::steady_clock::time_point> deadline {};
+};
+
+// Fuel of a parallel loop, shared by its workers. They take it in batches, so the counter is touched once per BATCH units,
+// and fall back to the fuel of an enclosing loop.
+struct SharedFuel
+{
+    static constexpr uint64_t BATCH = 4 * RuntimeBudget::DEADLINE_CHECK_INTERVAL;
+
+    explicit SharedFuel(uint64_t inRemaining, SharedFuel* inParent = nullptr) : remaining(inRemaining), parent(inParent) {};
+
+    // refills empty fuel of a worker, false once nothing is left
+    bool take(uint64_t& fuel)
+    {
+        auto current = remaining.load(std::memory_order_relaxed);
+        while(current != 0)
+        {
+            const auto batch = std::min(current, BATCH);
+            if(remaining.compare_exchange_weak(current, current - batch, std::memory_order_relaxed))
+            {
+                fuel = batch;
+                return true;
+            }
+        }
+        return parent && parent->take(fuel);
+    }
+
+    void give(uint64_t fuel) { remaining.fetch_add(fuel, std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> remaining;
+    SharedFuel* parent;
+};
+
+// thrown after the "budget exhausted" message, lets embedders tell it apart from script errors
+struct BudgetExhausted : public std::runtime_error
+{
+    BudgetExhausted() : std::runtime_error("budget exhausted") {};
+};
+
+// Variables live in flat slot array, indexed by (depth, slot) resolved by AstResolver.
+// Empty slot means variable is not assigned yet.
 struct RuntimeScope
 {
-    explicit RuntimeScope(RuntimeScope* inParent) : parent(inParent) {};
+    explicit RuntimeScope(RuntimeScope* inParent, size_t inSize = 0) : slots(inSize), parent(inParent) {};
+
+    RuntimeScope& scopeAt(uint16_t depth)
+    {
+        RuntimeScope* scope = this;
+        for(uint16_t i = 0; i != depth; i++)
+            scope = scope->parent;
+        return *scope;
+    }
+
+    std::optional<TemporaryValue::Any>& getSlot(uint16_t depth, uint32_t slot) { return scopeAt(depth).slots[slot]; }
+
+    TemporaryValue::Any* getVariable(uint16_t depth, uint32_t slot)
+    {
+        auto& variable = getSlot(depth, slot);
+        return variable ? &*variable : nullptr;
+    }
+
+    // global scope grows when later inputs declare new names
+    void resize(size_t size)
+    {
+        if(slots.size() < size)
+            slots.resize(size);
+    }
+
+    std::vector<std::optional<TemporaryValue::Any>> slots {};
+    RuntimeScope* parent;
+};
+
+// Stack of scopes reused between entries, once the pool and slot capacity have grown taking a scope does not allocate.
+// Scopes are returned in reverse order of taking them.
+class RuntimeScopePool
+{
+public:
+    RuntimeScope& push(RuntimeScope* parent, size_t size)
+    {
+        if(inUse == scopes.size())
+            scopes.emplace_back(parent);
+        auto& scope = scopes[inUse++];
+        scope.parent = parent;
+        scope.slots.resize(size);
+        return scope;
+    }
+
+    void pop()
+    {
+        scopes[--inUse].slots.clear();
+    }
+
+    // returns every taken scope, after a run interrupted by error
+    void clear()
+    {
+        while(inUse != 0)
+            pop();
+    }
+
+    size_t size() const { return inUse; }
+
+private:
+    std::deque<RuntimeScope> scopes {};
+    size_t inUse {0};
+};
+
+// State of one execution shared by every scope of it.
+// 'ret' sets completion instead of throwing, blocks and loops stop when it is not Normal.
+struct RuntimeContext
+{
+    enum class Completion : uint8_t { Normal, Return };
+
+    RuntimeContext(RuntimeScope& inGlobalScope, OutputSink& inOutput, RuntimeBudget inBudget = {})
+        : globalScope(inGlobalScope), output(inOutput), fuel(inBudget.fuel), deadline(inBudget.deadline) {};
+
+    bool completedNormally() const { return completion == Completion::Normal; }
 
-    TemporaryValue::Any* getVariable(std::string inName)
+    // prepares context for the next run with a new budget, keeps capacity of scope pools
+    void restart(RuntimeBudget inBudget)
     {
-        if(variables.find(inName) != variables.end())
+        completion = Completion::Normal;
+        returnValue = {};
+        frames.clear();
+        scopes.clear();
+        fuel = inBudget.fuel;
+        deadline = inBudget.deadline;
+        deadlinePassed = false;
+    }
+
+    // takes one unit of fuel at loop back-edge or call, false once fuel or time ran out
+    bool consumeFuel()
+    {
+        if(fuel == 0) [[unlikely]]
         {
-            return &variables[inName];
+            if(!sharedFuel || deadlinePassed || !sharedFuel->take(fuel))
+                return false;
         }
-        if(parent)
+        --fuel;
+        if(deadline && fuel % RuntimeBudget::DEADLINE_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= *deadline) [[unlikely]]
         {
-            return parent->getVariable(inName);
+            deadlinePassed = true;
+            fuel = 0;
+            return false;
         }
-        return nullptr;
+        return true;
     }
 
-    std::map<std::string,TemporaryValue::Any> variables {};
-    RuntimeScope* parent;
+    const char* exhaustedReason() const { return deadlinePassed ? "deadline passed" : "out of fuel"; }
+    uint64_t remainingFuel() const { return fuel; }
+
+    // budget of a parallel loop worker, which starts empty and refuels from the loop's SharedFuel
+    RuntimeBudget workerBudget() const { return RuntimeBudget{.fuel = 0, .deadline = deadline}; }
+    // parallel loop moves the fuel into its SharedFuel while workers run and gives back what they left
+    uint64_t takeFuel() { return std::exchange(fuel, 0); }
+    void giveFuel(uint64_t inFuel) { fuel += inFuel; }
+
+    // function frames are parented to global scope
+    RuntimeScope& pushFrame(size_t size) { return frames.push(&globalScope, size); }
+    void popFrame() { frames.pop(); }
+    size_t callDepth() const { return frames.size(); }
+
+    // scopes of blocks, if branches and loops which declare something, others are elided by AstResolver
+    RuntimeScope& pushScope(RuntimeScope& parent, size_t size) { return scopes.push(&parent, size); }
+    void popScope() { scopes.pop(); }
+    size_t scopeCount() const { return scopes.size(); }
+
+    RuntimeScope& globalScope;
+    OutputSink& output; // receives PrintStmt values
+    Completion completion {Completion::Normal};
+    TemporaryValue::Any returnValue {};
+
+    RuntimeScopePool frames {};
+    RuntimeScopePool scopes {};
+    SharedFuel* sharedFuel {nullptr}; // set for workers of a parallel loop
+
+    // set for workers of a parallel loop, their globalScope is the one of the loop's context, which they only read
+    bool sharedGlobals {false};
+    bool isSharedScope(const RuntimeScope& scope) const { return sharedGlobals && &scope == &globalScope; }
+
+private:
+    uint64_t fuel;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    bool deadlinePassed {false};
 };
@@ -0,0 +1,166 @@
+#include "ScriptRunner.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "AstOptimizer.hpp"
+#include "AstParser.hpp"
+#include "AstTreeWalkInterpreter.hpp"
+#include "ByteCodeCompiler.hpp"
+#include "ByteCodeVm.hpp"
+#include "Diagnostics.hpp"
+#include "LexScanner.hpp"
+#include "LexTokenBuffer.hpp"
+
+const std::vector<std::string> SEPARATORS = {"+","-","*","^","/","%","(",")","==","!=","<",">","<=",">=","!","&&","||","{","}","[","]",":=",",","fn"};
+
+namespace
+{
+    // durations of finished stages, in order
+    struct StageTimer
+    {
+        using Clock = std::chrono::steady_clock;
+
+        void finish(const char* stage)
+        {
+            const auto now = Clock::now();
+            stages.emplace_back(stage, now - last);
+            last = now;
+        }
+
+        void report(std::ostream& os) const
+        {
+            Clock::duration total {};
+            for(auto& [stage, duration] : stages)
+            {
+                os << std::left << std::setw(10) << stage << toMs(duration) << " ms\n";
+                total += duration;
+            }
+            os << std::left << std::setw(10) << "total" << toMs(total) << " ms\n";
+        }
+
+        static double toMs(Clock::duration in) { return std::chrono::duration<double, std::milli>(in).count(); }
+
+        Clock::time_point last {Clock::now()};
+        std::vector<std::pair<const char*, Clock::duration>> stages {};
+    };
+
+    struct RunStats
+    {
+        size_t tokens {};
+        size_t astNodes {};
+        size_t instructions {};
+        uint64_t fuelUsed {};
+
+        void report(std::ostream& os, bool useVm) const
+        {
+            os << "tokens       " << tokens << "\n";
+            os << "ast nodes    " << astNodes << "\n";
+            if(useVm)
+                os << "instructions " << instructions << "\n";
+            os << "fuel used    " << fuelUsed << "\n";
+        }
+    };
+}
+
+bool runSource(const std::shared_ptr<CodeSource>& source, RuntimeScope& rootScope, AstResolver& resolver, OutputSink& output, const RunOptions& options)
+{
+    StageTimer timer;
+    RunStats stats;
+    bool succeeded = true;
+    std::optional<RuntimeContext> context; // outlives failed run, so stats still see used fuel
+    uint32_t sourceId = CodeSourceRegistry::NO_SOURCE; // released once run finished, functions it declared keep their own reference
+
+    // kept until the program output is flushed, so both keep their order on a terminal
+    std::ostringstream errors;
+    std::optional<DiagnosticsRedirect> redirect;
+    if(options.errorsToStderr)
+        redirect.emplace(errors);
+
+    try
+    {
+        LexScanner scanner(source,SEPARATORS);
+        sourceId = scanner.getSourceId();
+        LexTokenBuffer tokens(scanner);
+        timer.finish("lex");
+        stats.tokens = tokens.size();
+
+        if(options.dumpTokens)
+        {
+            std::cout << "TOKEKNS: \n";
+            for(size_t i = 0; i != tokens.size(); i++)
+                std::cout << tokens.at(i) << "\n";
+        }
+
+        AstNode::Arena arena;
+        auto root = AstParser(tokens, arena).block();
+        timer.finish("parse");
+        if(options.optimize)
+        {
+            root = AstOptimizer(arena).optimize(root);
+            timer.finish("optimize");
+        }
+        stats.astNodes = arena.nodeCount();
+        if(options.dumpAst)
+            std::cout << "\nAST: \n" << *root << "\n";
+
+        resolver.resolve(root);
+        rootScope.resize(resolver.globalCount());
+        timer.finish("resolve");
+
+        RuntimeBudget budget {.fuel = options.fuel};
+        if(options.timeout)
+            budget.deadline = std::chrono::steady_clock::now() + *options.timeout;
+        context.emplace(rootScope, output, budget);
+
+        if(options.useVm)
+        {
+            auto chunk = ByteCodeCompiler().compile(root);
+            timer.finish("compile");
+            stats.instructions = chunk.code.size();
+            if(options.dumpBytecode)
+                std::cout << "\nBYTECODE: \n" << chunk;
+
+            if(options.dumpsAnything())
+                std::cout << "\nINTERPRET: \n";
+            ByteCodeVm(*context).run(chunk);
+        }
+        else
+        {
+            if(options.dumpsAnything())
+                std::cout << "\nINTERPRET: \n";
+            treeWallInterpret(root,*context,rootScope,true);
+        }
+        timer.finish("run");
+
+        if(!context->completedNormally())
+        {
+            diagnostics() << "\nTried return from main scope \n";
+            succeeded = false;
+        }
+        else if(options.dumpsAnything())
+            std::cout << "\n";
+    }
+    catch(std::exception& e)
+    {
+        diagnostics() << "\nERROR OCCURED: more info above \n";
+        succeeded = false;
+    }
+    CodeSourceRegistry::release(sourceId);
+
+    if(context)
+        stats.fuelUsed = options.fuel - context->remainingFuel();
+
+    if(options.errorsToStderr || options.timing || options.stats)
+    {
+        std::cout.flush(); // program output first, messages and reports go to unbuffered std::cerr
+        output.flush();
+        std::cerr << errors.str();
+        if(options.timing)
+            timer.report(std::cerr);
+        if(options.stats)
+            stats.report(std::cerr, options.useVm);
+    }
+    return succeeded;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "AstResolver.hpp"
+#include "CodeSource.hpp"
+#include "OutputSink.hpp"
+#include "RuntimeScope.hpp"
+
+extern const std::vector<std::string> SEPARATORS;
+
+struct RunOptions
+{
+    bool useVm {false};
+    bool optimize {true};
+
+    // debug output on std::cout before the program output, off for headless runs
+    bool dumpTokens {false};
+    bool dumpAst {false};
+    bool dumpBytecode {false}; // only with useVm
+
+    // diagnostics and error messages on std::cerr after the program output instead of in order with it on std::cout
+    bool errorsToStderr {false};
+
+    // reports on std::cerr after the run, so they never mix with the program output
+    bool timing {false};    // duration of every stage
+    bool stats {false};     // sizes of intermediate forms and used fuel
+
+    uint64_t fuel {RuntimeBudget::DEFAULT_FUEL};
+    std::optional<std::chrono::milliseconds> timeout {}; // wall clock limit of the execution, counted from its start
+
+    bool dumpsAnything() const { return dumpTokens || dumpAst || dumpBytecode; }
+};
+
+// lexes, parses and executes source in rootScope, printed values go to output and diagnostics to std::cout
+// (std::cerr with errorsToStderr), returns false when execution stopped on error
+bool runSource(const std::shared_ptr<CodeSource>& source, RuntimeScope& rootScope, AstResolver& resolver, OutputSink& output, const RunOptions& options);
@@ -1,9 +1,16 @@
 
 #include "TemporaryValue.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iterator>
 #include <ostream>
 #include "vx.hpp"
 
+#include "ArraySimd.hpp"
 #include "AstNode.hpp"
+#include "Diagnostics.hpp"
+#include "OutputSink.hpp"
 
 std::ostream& operator<<(std::ostream& os, const TemporaryValue::Any& in)
 {
@@ -12,68 +19,393 @@ std::ostream& operator<<(std::ostream& os, const TemporaryValue::Any& in)
         [&os,&in](const TemporaryValue::Integer& v)    { os << "TemporaryValue::Integer{" << v.value << "}";},
         [&os,&in](const TemporaryValue::Float& v)      { os << "TemporaryValue::Float{" << v.value << "}";},
         [&os,&in](const TemporaryValue::String& v)     { os << "TemporaryValue::String{" << v.value << "}";},
-        [&os,&in](const TemporaryValue::Func& v)       { os << "TemporaryValue::Func{" << v.value << "}";}
+        [&os,&in](const TemporaryValue::Func& v)       { os << "TemporaryValue::Func{" << v.value->decl << "}";},
+        [&os,&in](const TemporaryValue::Array& v)
+        {
+            // long arrays end up in error messages, only their beginning is shown
+            constexpr size_t SHOWN = 8;
+            os << "TemporaryValue::Array{";
+            for(size_t i = 0; i != std::min(v.value.size(), SHOWN); i++)
+                os << (i == 0 ? "" : ", ") << v.value[i];
+            if(v.value.size() > SHOWN)
+                os << ", ... " << v.value.size() << " elements";
+            os << "}";
+        }
     };
     return os;
 }
 
-float TemporaryValue::getFloat(TemporaryValue::Any& in)
+const std::shared_ptr<const TemporaryValue::FuncBody>& TemporaryValue::FuncBody::of(const AstNode::FunctionDecl& decl)
 {
-    if(in|vx::is<Integer>)
+    if(!decl.sharedBody)
     {
-        //std::cout << "WRN: context required conversion to Float from " << in << "'\n";
-        return static_cast<float>((in|vx::as<Integer>).value);
+        auto body = std::make_shared<FuncBody>();
+        body->decl = static_cast<const AstNode::FunctionDecl*>(decl.copy(body->arena));
+        body->sourceId = decl.tokenValue.source.sourceId;
+        CodeSourceRegistry::retain(body->sourceId);
+        decl.sharedBody = std::move(body);
     }
-    if(in|vx::is<Float>)
-        return (in|vx::as<Float>).value;
+    return decl.sharedBody;
+}
 
-    std::cout << "unsupported conversion to Float from:'" << in << "'\n";
-    throw std::runtime_error("conversion error");
+TemporaryValue::FuncBody::~FuncBody()
+{
+    CodeSourceRegistry::release(sourceId);
 }
 
-std::string TemporaryValue::getString(TemporaryValue::Any& in)
+float TemporaryValue::getFloat(const TemporaryValue::Any& in)
 {
-    if(in|vx::is<Integer>)
+    switch(in.getTag())
     {
-        //std::cout << "WRN: context required conversion to String from " << in << "'\n";
-        return std::to_string((in|vx::as<Integer>).value);
+        case Any::Tag::Integer: return static_cast<float>((in|vx::as<Integer>).value);
+        case Any::Tag::Float:   return (in|vx::as<Float>).value;
+        default:                break;
     }
-    if(in|vx::is<Bool>)
-    {
-        //std::cout << "WRN: context required conversion to String from " << in << "'\n";
-        return (in|vx::as<Bool>).value ? "true" : "false";
-    }
-    if(in|vx::is<Float>)
+
+    diagnostics() << "unsupported conversion to Float from:'" << in << "'\n";
+    throw std::runtime_error("conversion error");
+}
+
+std::string TemporaryValue::getString(const TemporaryValue::Any& in)
+{
+    switch(in.getTag())
     {
-        //std::cout << "WRN: context required conversion to String from " << in << "'\n";
-        return std::to_string((in|vx::as<Float>).value);
+        case Any::Tag::Integer: return std::to_string((in|vx::as<Integer>).value);
+        case Any::Tag::Bool:    return (in|vx::as<Bool>).value ? "true" : "false";
+        case Any::Tag::Float:   return std::to_string((in|vx::as<Float>).value);
+        case Any::Tag::String:  return (in|vx::as<String>).value;
+        default:                break;
     }
-    if(in|vx::is<String>)
-        return (in|vx::as<String>).value;
 
-    std::cout << "unsupported conversion to Float from:'" << in << "'\n";
+    diagnostics() << "unsupported conversion to Float from:'" << in << "'\n";
     throw std::runtime_error("conversion error");
 }
 
-int TemporaryValue::getInteger(TemporaryValue::Any& in)
+int TemporaryValue::getInteger(const TemporaryValue::Any& in)
 {
-    if(in|vx::is<Integer>)
-        return static_cast<float>((in|vx::as<Integer>).value);
-    if(in|vx::is<Float>)
+    switch(in.getTag())
     {
-        //std::cout << "WRN: context required conversion to Integer from " << in << "'\n";
-        return static_cast<int>((in|vx::as<Float>).value);
+        case Any::Tag::Integer: return (in|vx::as<Integer>).value;
+        case Any::Tag::Float:   return static_cast<int>((in|vx::as<Float>).value);
+        default:                break;
     }
 
-    std::cout << "unsupported conversion to Float from:'" << in << "'\n";
+    diagnostics() << "unsupported conversion to Float from:'" << in << "'\n";
     throw std::runtime_error("conversion error");
 }
 
-bool TemporaryValue::getBool(TemporaryValue::Any& in)
+bool TemporaryValue::getBool(const TemporaryValue::Any& in)
 {
-    if(in|vx::is<Bool>)
+    if(in.getTag() == Any::Tag::Bool) [[likely]]
         return (in|vx::as<Bool>).value;
 
-    std::cout << "unsupported conversion to Bool from:'" << in << "'\n";
+    diagnostics() << "unsupported conversion to Bool from:'" << in << "'\n";
     throw std::runtime_error("conversion error");
-}
\ No newline at end of file
+}
+
+std::optional<TemporaryValue::UnaryOperator> TemporaryValue::toUnaryOperator(LexToken::SeparatorKind in)
+{
+    switch(in)
+    {
+        case LexToken::SeparatorKind::Minus:    return UnaryOperator::Negate;
+        case LexToken::SeparatorKind::Plus:     return UnaryOperator::Identity;
+        case LexToken::SeparatorKind::Bang:     return UnaryOperator::Not;
+        default:                                return {};
+    }
+}
+
+std::optional<TemporaryValue::BinaryOperator> TemporaryValue::toBinaryOperator(LexToken::SeparatorKind in)
+{
+    switch(in)
+    {
+        case LexToken::SeparatorKind::Plus:         return BinaryOperator::Add;
+        case LexToken::SeparatorKind::Minus:        return BinaryOperator::Subtract;
+        case LexToken::SeparatorKind::Star:         return BinaryOperator::Multiply;
+        case LexToken::SeparatorKind::Slash:        return BinaryOperator::Divide;
+        case LexToken::SeparatorKind::Percent:      return BinaryOperator::Modulo;
+        case LexToken::SeparatorKind::Caret:        return BinaryOperator::Power;
+        case LexToken::SeparatorKind::EqualEqual:   return BinaryOperator::Equal;
+        case LexToken::SeparatorKind::BangEqual:    return BinaryOperator::NotEqual;
+        case LexToken::SeparatorKind::Less:         return BinaryOperator::Less;
+        case LexToken::SeparatorKind::Greater:      return BinaryOperator::Greater;
+        case LexToken::SeparatorKind::LessEqual:    return BinaryOperator::LessEqual;
+        case LexToken::SeparatorKind::GreaterEqual: return BinaryOperator::GreaterEqual;
+        default:                                    return {};
+    }
+}
+
+TemporaryValue::Any TemporaryValue::unaryOp(UnaryOperator op, const Any& in)
+{
+    switch(op)
+    {
+        case UnaryOperator::Negate:
+            if(in|vx::is<Array>)
+            {
+                const auto& elements = (in|vx::as<Array>).value;
+                Array result {std::vector<float>(elements.size())};
+                ArraySimd::applyLeft(ArraySimd::Op::Multiply, -1.0f, elements.data(), result.value.data(), elements.size()); // keeps sign of zeros as Float does
+                return result;
+            }
+            if(in|vx::is<Float>)
+                return Float{-(in|vx::as<Float>).value};
+            if(in|vx::is<Integer>)
+                return Integer{-(in|vx::as<Integer>).value};
+            break;
+        case UnaryOperator::Identity:
+            if(in|vx::is<Array>)
+                return in;
+            if(in|vx::is<Float>)
+                return Float{(in|vx::as<Float>).value};
+            if(in|vx::is<Integer>)
+                return Integer{(in|vx::as<Integer>).value};
+            break;
+        case UnaryOperator::Not:
+            if(in|vx::is<Bool>)
+                return Bool{!(in|vx::as<Bool>).value};
+            break;
+    }
+    return {};
+}
+
+namespace
+{
+    using namespace TemporaryValue;
+
+    bool isNumber(const Any& in)
+    {
+        return in.is<Integer>() || in.is<Float>();
+    }
+
+    std::optional<ArraySimd::Op> toArrayOp(BinaryOperator op)
+    {
+        switch(op)
+        {
+            case BinaryOperator::Add:           return ArraySimd::Op::Add;
+            case BinaryOperator::Subtract:      return ArraySimd::Op::Subtract;
+            case BinaryOperator::Multiply:      return ArraySimd::Op::Multiply;
+            case BinaryOperator::Divide:        return ArraySimd::Op::Divide;
+            case BinaryOperator::Equal:         return ArraySimd::Op::Equal;
+            case BinaryOperator::NotEqual:      return ArraySimd::Op::NotEqual;
+            case BinaryOperator::Less:          return ArraySimd::Op::Less;
+            case BinaryOperator::Greater:       return ArraySimd::Op::Greater;
+            case BinaryOperator::LessEqual:     return ArraySimd::Op::LessEqual;
+            case BinaryOperator::GreaterEqual:  return ArraySimd::Op::GreaterEqual;
+            default:                            return {};
+        }
+    }
+
+    // at least one operand is Array, the other one is a number or Array of the same size; '%' is unsupported as for Float
+    std::optional<Any> arrayBinaryOp(BinaryOperator op, const Any& left, const Any& right)
+    {
+        const auto* leftElements = left.is<Array>() ? &left.as<Array>().value : nullptr;
+        const auto* rightElements = right.is<Array>() ? &right.as<Array>().value : nullptr;
+        if((!leftElements && !isNumber(left)) || (!rightElements && !isNumber(right)))
+            return {};
+        if(leftElements && rightElements && leftElements->size() != rightElements->size())
+            return {};
+
+        const size_t size = leftElements ? leftElements->size() : rightElements->size();
+        Array result {std::vector<float>(size)};
+        float* out = result.value.data();
+
+        if(op == BinaryOperator::Power) // no vector instruction, same std::pow as Float
+        {
+            const float leftNumber = leftElements ? 0.0f : getFloat(left);
+            const float rightNumber = rightElements ? 0.0f : getFloat(right);
+            for(size_t i = 0; i != size; i++)
+                out[i] = std::pow(leftElements ? (*leftElements)[i] : leftNumber, rightElements ? (*rightElements)[i] : rightNumber);
+            return result;
+        }
+
+        const auto arrayOp = toArrayOp(op);
+        if(!arrayOp)
+            return {};
+        if(leftElements && rightElements)
+            ArraySimd::apply(*arrayOp, leftElements->data(), rightElements->data(), out, size);
+        else if(leftElements)
+            ArraySimd::applyRight(*arrayOp, leftElements->data(), getFloat(right), out, size);
+        else
+            ArraySimd::applyLeft(*arrayOp, getFloat(left), rightElements->data(), out, size);
+        return result;
+    }
+
+    // non negative Integer not above MAX_ARRAY_SIZE
+    std::optional<size_t> arraySize(const Any& in)
+    {
+        if(!in.is<Integer>() || in.as<Integer>().value < 0 || static_cast<size_t>(in.as<Integer>().value) > MAX_ARRAY_SIZE)
+            return {};
+        return static_cast<size_t>(in.as<Integer>().value);
+    }
+}
+
+std::optional<TemporaryValue::Any> TemporaryValue::binaryOp(BinaryOperator op, const Any& left, const Any& right)
+{
+    if(left|vx::is<Array> || right|vx::is<Array>)
+        return arrayBinaryOp(op, left, right);
+
+    if(left|vx::is<Bool>)
+    {
+        if(op == BinaryOperator::Equal)
+            return Bool{getBool(left) == getBool(right)};
+        if(op == BinaryOperator::NotEqual)
+            return Bool{getBool(left) != getBool(right)};
+        return Any{};
+    }
+
+    switch(operandTypes(left, right))
+    {
+        case OperandTypes::Integers:
+            return integerBinaryOp(op, getInteger(left), getInteger(right));
+        case OperandTypes::Floats: // If any argument is float, promote to float
+            return floatBinaryOp(op, getFloat(left), getFloat(right));
+        default:
+            break;
+    }
+
+    if(left|vx::is<String> || right|vx::is<String>)
+    {
+        if(op == BinaryOperator::Equal)
+            return Bool{getString(left) == getString(right)};
+        if(op == BinaryOperator::NotEqual)
+            return Bool{getString(left) != getString(right)};
+        if(op == BinaryOperator::Add)
+            return String{getString(left) + getString(right)};
+    }
+
+    return {};
+}
+
+void TemporaryValue::integerDivisionError(int r)
+{
+    diagnostics() << (r == 0 ? "division by zero\n" : "integer overflow\n");
+    throw ArithmeticError("");
+}
+
+std::optional<TemporaryValue::Builtin> TemporaryValue::toBuiltin(std::string_view name)
+{
+    if(name == "len")   return Builtin::Len;
+    if(name == "sum")   return Builtin::Sum;
+    if(name == "min")   return Builtin::Min;
+    if(name == "max")   return Builtin::Max;
+    if(name == "dot")   return Builtin::Dot;
+    if(name == "range") return Builtin::Range;
+    if(name == "fill")  return Builtin::Fill;
+    return {};
+}
+
+size_t TemporaryValue::builtinArity(Builtin in)
+{
+    switch(in)
+    {
+        case Builtin::Dot:
+        case Builtin::Range:
+        case Builtin::Fill:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+std::optional<TemporaryValue::Any> TemporaryValue::callBuiltin(Builtin fn, const Any* args)
+{
+    if(fn == Builtin::Range)
+    {
+        if(!args[0].is<Integer>() || !args[1].is<Integer>())
+            return {};
+        const int64_t begin = args[0].as<Integer>().value;
+        const int64_t end = args[1].as<Integer>().value;
+        if(end > begin && static_cast<uint64_t>(end - begin) > MAX_ARRAY_SIZE)
+            return {};
+
+        Array result {std::vector<float>(end > begin ? static_cast<size_t>(end - begin) : 0)};
+        for(size_t i = 0; i != result.value.size(); i++)
+            result.value[i] = static_cast<float>(begin + static_cast<int64_t>(i));
+        return result;
+    }
+    if(fn == Builtin::Fill)
+    {
+        const auto size = arraySize(args[0]);
+        if(!size || !isNumber(args[1]))
+            return {};
+        return Array{std::vector<float>(*size, getFloat(args[1]))};
+    }
+    if(fn == Builtin::Len && args[0].is<String>())
+        return Integer{static_cast<int>(args[0].as<String>().value.size())};
+
+    if(!args[0].is<Array>())
+        return {};
+    const auto& elements = args[0].as<Array>().value;
+    switch(fn)
+    {
+        case Builtin::Len:  return Integer{static_cast<int>(elements.size())};
+        case Builtin::Sum:  return Float{ArraySimd::sum(elements.data(), elements.size())};
+        case Builtin::Min:  return elements.empty() ? std::nullopt : std::optional<Any>(Float{ArraySimd::min(elements.data(), elements.size())});
+        case Builtin::Max:  return elements.empty() ? std::nullopt : std::optional<Any>(Float{ArraySimd::max(elements.data(), elements.size())});
+        case Builtin::Dot:
+        {
+            if(!args[1].is<Array>() || args[1].as<Array>().value.size() != elements.size())
+                return {};
+            return Float{ArraySimd::dot(elements.data(), args[1].as<Array>().value.data(), elements.size())};
+        }
+        default:
+            return {};
+    }
+}
+
+std::optional<TemporaryValue::Any> TemporaryValue::makeArray(const Any* values, size_t count)
+{
+    if(count > MAX_ARRAY_SIZE)
+        return {};
+
+    Array result {std::vector<float>(count)};
+    for(size_t i = 0; i != count; i++)
+    {
+        if(!isNumber(values[i]))
+            return {};
+        result.value[i] = getFloat(values[i]);
+    }
+    return result;
+}
+
+std::optional<TemporaryValue::Any> TemporaryValue::indexArray(const Any& array, const Any& index)
+{
+    if(!array.is<Array>() || !index.is<Integer>())
+        return {};
+    const auto& elements = array.as<Array>().value;
+    const int at = index.as<Integer>().value;
+    if(at < 0 || static_cast<size_t>(at) >= elements.size())
+        return {};
+    return Float{elements[at]};
+}
+
+void TemporaryValue::print(OutputSink& out, const Any& in)
+{
+    char number[32];
+    const auto printFloat = [&](float value) // same as ostream default: %g with precision 6
+    {
+        const auto end = std::to_chars(std::begin(number), std::end(number), value, std::chars_format::general, 6).ptr;
+        out.write(std::string_view(number, end - number));
+    };
+    in |vx::match {
+        [&out](const Bool& v)       { out.write(v.value ? "true" : "false");},
+        [&](const Integer& v)
+        {
+            const auto end = std::to_chars(std::begin(number), std::end(number), v.value).ptr;
+            out.write(std::string_view(number, end - number));
+        },
+        [&](const Float& v)         { printFloat(v.value);},
+        [&out](const String& v)     { out.write(v.value);},
+        [&out](const Func&)         { out.write("<func>");},
+        [&](const Array& v)
+        {
+            out.write("[");
+            for(size_t i = 0; i != v.value.size(); i++)
+            {
+                if(i != 0)
+                    out.write(", ");
+                printFloat(v.value[i]);
+            }
+            out.write("]");
+        }
+    };
+}
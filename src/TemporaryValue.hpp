@@ -1,10 +1,21 @@
 #pragma once
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include "AstNode.hpp"
 
+class OutputSink;
+
 namespace TemporaryValue
 {
     template<typename T>
@@ -19,30 +30,325 @@ namespace TemporaryValue
     struct Float        final       : public WithContent<float>       {};
     struct String       final       : public WithContent<std::string> {};
 
-    struct Func         final       : public WithContent<AstNode::OwnedNode>
+    // immutable copy of the declaration, so value does not depend on lifetime of parsed tree
+    struct FuncBody
+    {
+        // body of decl, copied on first use and cached on the node, copies of the node share it
+        static const std::shared_ptr<const FuncBody>& of(const AstNode::FunctionDecl& decl);
+
+        FuncBody() = default;
+        ~FuncBody();
+        FuncBody(const FuncBody&) = delete;
+        FuncBody& operator=(const FuncBody&) = delete;
+
+        AstNode::Arena arena {};
+        const AstNode::FunctionDecl* decl {};
+        uint32_t sourceId {}; // referenced from CodeSourceRegistry, tokens of decl view its text and it outlives the input that declared it
+
+        // backend specific code (ByteCode::Chunk for ByteCodeVm) made by compile() on first use,
+        // threads calling it concurrently compile once and all get the same code
+        template<typename T, typename Compile>
+        const T& compiledAs(Compile compile) const
+        {
+            if(auto code = compiledCode.load(std::memory_order_acquire)) [[likely]]
+                return *static_cast<const T*>(code);
+            std::call_once(compileOnce, [&]()
+            {
+                compiled = std::make_shared<const T>(compile());
+                compiledCode.store(compiled.get(), std::memory_order_release);
+            });
+            return *static_cast<const T*>(compiled.get());
+        }
+
+    private:
+        mutable std::once_flag compileOnce {};
+        mutable std::shared_ptr<const void> compiled {};
+        mutable std::atomic<const void*> compiledCode {};
+    };
+
+    // copies share one body, so passing function around is a refcount increment
+    struct Func         final       : public WithContent<std::shared_ptr<const FuncBody>>
     {
-        Func(AstNode::OwnedNode node)
+        // evaluating declaration again reuses its FuncBody::of
+        explicit Func(const AstNode::FunctionDecl& decl) : WithContent{FuncBody::of(decl)} {};
+
+        const AstNode::FunctionDecl& decl() const { return *value->decl; }
+    };
+
+    // contiguous Float elements, arithmetic and comparisons with a number or an Array of the same size apply element-wise
+    struct Array        final       : public WithContent<std::vector<float>> {};
+
+    // longest Array scripts may create, keeps a typo in a size from allocating all memory
+    constexpr size_t MAX_ARRAY_SIZE = size_t{1} << 26;
+
+    // 16 byte tagged value: Bool, Integer and Float are stored inline,
+    // String, Func and Array live in immutable refcounted boxes, so copying a value never allocates.
+    // Default value is Bool{false}.
+    class Any
+    {
+    public:
+        enum class Tag : uint8_t { Bool, Integer, Float, String, Func, Array };
+
+        Any() : Any(Bool{false}) {}
+        Any(Bool in) : tag(Tag::Bool) { payload.boolean = in.value; }
+        Any(Integer in) : tag(Tag::Integer) { payload.integer = in.value; }
+        Any(Float in) : tag(Tag::Float) { payload.floating = in.value; }
+        Any(String in) : tag(Tag::String) { payload.string = new Boxed<String>{{1}, std::move(in)}; }
+        Any(Func in) : tag(Tag::Func) { payload.func = new Boxed<Func>{{1}, std::move(in)}; }
+        Any(Array in) : tag(Tag::Array) { payload.array = new Boxed<Array>{{1}, std::move(in)}; }
+
+        Any(const Any& o) : tag(o.tag), payload(o.payload) { retain(); }
+        Any(Any&& o) noexcept : tag(o.tag), payload(o.payload) { o.tag = Tag::Bool; o.payload.boolean = false; }
+        Any& operator=(const Any& o)
+        {
+            Any copied(o);
+            return *this = std::move(copied);
+        }
+        Any& operator=(Any&& o) noexcept
+        {
+            if(this != &o)
+            {
+                release();
+                tag = o.tag;
+                payload = o.payload;
+                o.tag = Tag::Bool;
+                o.payload.boolean = false;
+            }
+            return *this;
+        }
+        ~Any() { release(); }
+
+        Tag getTag() const { return tag; }
+        size_t index() const { return static_cast<size_t>(tag); } // same numbering as alternatives of former std::variant
+
+        template<typename T>
+        bool is() const { return tag == tagOf<T>(); }
+
+        // Bool, Integer and Float by value, String, Func and Array by reference into the shared box
+        template<typename T>
+        decltype(auto) as() const
         {
-            value = std::move(node);
+            if constexpr (std::is_same_v<T, Bool>)          return Bool{payload.boolean};
+            else if constexpr (std::is_same_v<T, Integer>)  return Integer{payload.integer};
+            else if constexpr (std::is_same_v<T, Float>)    return Float{payload.floating};
+            else if constexpr (std::is_same_v<T, String>)   return static_cast<const String&>(payload.string->value);
+            else if constexpr (std::is_same_v<T, Func>)     return static_cast<const Func&>(payload.func->value);
+            else                                            return static_cast<const Array&>(payload.array->value);
         }
-        Func(const Func& o)
+
+        template<typename F>
+        decltype(auto) visit(F&& f) const
         {
-            value = o.value->copy();
+            switch(tag)
+            {
+                case Tag::Bool:     return f(as<Bool>());
+                case Tag::Integer:  return f(as<Integer>());
+                case Tag::Float:    return f(as<Float>());
+                case Tag::String:   return f(as<String>());
+                case Tag::Func:     return f(as<Func>());
+                case Tag::Array:    break;
+            }
+            return f(as<Array>());
         }
 
-        void operator=(const Func& o)
+    private:
+        template<typename T>
+        struct Boxed
         {
-            value = o.value->copy();
+            std::atomic<uint32_t> refs;
+            T value;
+        };
+
+        template<typename T>
+        static constexpr Tag tagOf()
+        {
+            if constexpr (std::is_same_v<T, Bool>)          return Tag::Bool;
+            else if constexpr (std::is_same_v<T, Integer>)  return Tag::Integer;
+            else if constexpr (std::is_same_v<T, Float>)    return Tag::Float;
+            else if constexpr (std::is_same_v<T, String>)   return Tag::String;
+            else if constexpr (std::is_same_v<T, Func>)     return Tag::Func;
+            else
+            {
+                static_assert(std::is_same_v<T, Array>);
+                return Tag::Array;
+            }
         }
 
+        void retain() const
+        {
+            if(tag == Tag::String)
+                payload.string->refs.fetch_add(1, std::memory_order_relaxed);
+            else if(tag == Tag::Func)
+                payload.func->refs.fetch_add(1, std::memory_order_relaxed);
+            else if(tag == Tag::Array)
+                payload.array->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if(tag == Tag::String && payload.string->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete payload.string;
+            else if(tag == Tag::Func && payload.func->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete payload.func;
+            else if(tag == Tag::Array && payload.array->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete payload.array;
+        }
+
+        Tag tag;
+        union Payload
+        {
+            bool boolean;
+            int integer;
+            float floating;
+            Boxed<String>* string;
+            Boxed<Func>* func;
+            Boxed<Array>* array;
+        } payload;
     };
 
-    using Any = std::variant<Bool,Integer,Float,String,Func>;
+    static_assert(sizeof(Any) == 16);
+
+    // vx::is / vx::as / vx::match on Any, found by ADL
+    template<typename T>
+    bool operator|(const Any& in, vx::compare<T>) { return in.is<T>(); }
+
+    template<typename T>
+    decltype(auto) operator|(const Any& in, vx::as_t<T>) { return in.as<T>(); }
+
+    template<typename... Fs>
+    decltype(auto) operator|(const Any& in, const vx::match<Fs...>& match) { return in.visit(match); }
+
+    float getFloat(const Any& in);
+    int getInteger(const Any& in);
+    bool getBool(const Any& in);
+    std::string getString(const Any& in);
+
+    enum class UnaryOperator : uint8_t
+    {
+        Negate, Identity, Not
+    };
+
+    enum class BinaryOperator : uint8_t
+    {
+        Add, Subtract, Multiply, Divide, Modulo, Power,
+        Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual
+    };
+
+    std::optional<UnaryOperator> toUnaryOperator(LexToken::SeparatorKind in);
+    std::optional<BinaryOperator> toBinaryOperator(LexToken::SeparatorKind in); // '&&' and '||' are short circuited by callers
+
+    // shared by every backend, so the tree walker and the vm agree on semantics
+    Any unaryOp(UnaryOperator op, const Any& in);
+    std::optional<Any> binaryOp(BinaryOperator op, const Any& left, const Any& right); // nullopt when operation is unsupported
+
+    // functions built into the language, every one takes a fixed number of arguments
+    enum class Builtin : uint8_t
+    {
+        Len, Sum, Min, Max, Dot, Range, Fill
+    };
+
+    constexpr size_t MAX_BUILTIN_ARITY = 2;
+
+    std::optional<Builtin> toBuiltin(std::string_view name);
+    size_t builtinArity(Builtin in);
+
+    // nullopt when arguments are unsupported: len, sum, min, max and dot of Arrays (min and max of non empty ones),
+    // range(begin, end) of consecutive integers and fill(size, value) of one repeated number
+    std::optional<Any> callBuiltin(Builtin fn, const Any* args);
+    // Array of numbers, nullopt for other values or too many of them
+    std::optional<Any> makeArray(const Any* values, size_t count);
+    // element of Array at Integer index as Float, nullopt when out of range
+    std::optional<Any> indexArray(const Any& array, const Any& index);
+
+    // operand types seen at a BinaryOp site, lets the site skip the type dispatch of binaryOp
+    enum class OperandTypes : uint8_t
+    {
+        Unknown,    // site not evaluated yet
+        Integers,   // Integer and Integer
+        Floats,     // two numbers, at least one Float
+        Mixed,      // anything else, also once a quickened site saw other types
+    };
+
+    inline OperandTypes operandTypes(const Any& left, const Any& right)
+    {
+        const bool leftNumber = left.is<Integer>() || left.is<Float>();
+        const bool rightNumber = right.is<Integer>() || right.is<Float>();
+        if(!leftNumber || !rightNumber)
+            return OperandTypes::Mixed;
+        return left.is<Integer>() && right.is<Integer>() ? OperandTypes::Integers : OperandTypes::Floats;
+    }
+
+    // thrown by integer '/' and '%' which have no result, after the reason is written to diagnostics,
+    // callers add where it happened and fail as on other runtime errors
+    struct ArithmeticError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+    // by zero or INT_MIN by -1, which overflows
+    inline bool integerDivisionFails(int l, int r) { return r == 0 || (l == INT_MIN && r == -1); }
+    [[noreturn]] void integerDivisionError(int r);
+
+    // binaryOp for OperandTypes::Integers, throws ArithmeticError when integerDivisionFails
+    inline Any integerBinaryOp(BinaryOperator op, int l, int r)
+    {
+        if((op == BinaryOperator::Divide || op == BinaryOperator::Modulo) && integerDivisionFails(l, r)) [[unlikely]]
+            integerDivisionError(r);
+
+        switch(op)
+        {
+            case BinaryOperator::Equal:         return Bool{l == r};
+            case BinaryOperator::NotEqual:      return Bool{l != r};
+            case BinaryOperator::Less:          return Bool{l < r};
+            case BinaryOperator::Greater:       return Bool{l > r};
+            case BinaryOperator::LessEqual:     return Bool{l <= r};
+            case BinaryOperator::GreaterEqual:  return Bool{l >= r};
+            case BinaryOperator::Add:           return Integer{l + r};
+            case BinaryOperator::Subtract:      return Integer{l - r};
+            case BinaryOperator::Multiply:      return Integer{l * r};
+            case BinaryOperator::Divide:        return Integer{l / r};
+            case BinaryOperator::Modulo:        return Integer{l % r};
+            case BinaryOperator::Power:         return Integer{static_cast<int>(std::pow(l,r))};
+        }
+        return {};
+    }
+
+    // binaryOp for OperandTypes::Floats, nullopt for '%'
+    inline std::optional<Any> floatBinaryOp(BinaryOperator op, float l, float r)
+    {
+        switch(op)
+        {
+            case BinaryOperator::Equal:         return Bool{l == r};
+            case BinaryOperator::NotEqual:      return Bool{l != r};
+            case BinaryOperator::Less:          return Bool{l < r};
+            case BinaryOperator::Greater:       return Bool{l > r};
+            case BinaryOperator::LessEqual:     return Bool{l <= r};
+            case BinaryOperator::GreaterEqual:  return Bool{l >= r};
+            case BinaryOperator::Add:           return Float{l + r};
+            case BinaryOperator::Subtract:      return Float{l - r};
+            case BinaryOperator::Multiply:      return Float{l * r};
+            case BinaryOperator::Divide:        return Float{l / r};
+            case BinaryOperator::Power:         return Float{std::pow(l,r)};
+            case BinaryOperator::Modulo:        break;
+        }
+        return {};
+    }
+
+    // number promoted to float, only for operands which passed OperandTypes::Floats
+    inline float numberAsFloat(const Any& in)
+    {
+        return in.is<Float>() ? in.as<Float>().value : static_cast<float>(in.as<Integer>().value);
+    }
+
+    // binaryOp of a site quickened to types, nullopt when operands fail the guard or the operation is unsupported,
+    // caller then falls back to binaryOp
+    inline std::optional<Any> quickBinaryOp(BinaryOperator op, OperandTypes types, const Any& left, const Any& right)
+    {
+        if(types == OperandTypes::Integers && left.is<Integer>() && right.is<Integer>())
+            return integerBinaryOp(op, left.as<Integer>().value, right.as<Integer>().value);
+        if(types == OperandTypes::Floats && operandTypes(left, right) == OperandTypes::Floats)
+            return floatBinaryOp(op, numberAsFloat(left), numberAsFloat(right));
+        return {};
+    }
 
-    float getFloat(Any& in);
-    int getInteger(Any& in);
-    bool getBool(Any& in);
-    std::string getString(Any& in);
+    void print(OutputSink& out, const Any& in); // as PrintStmt shows it, escapes of string literals are resolved by the parser
 }
 
 std::ostream& operator<<(std::ostream& os, const TemporaryValue::Any& in);
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+{
+    threads.reserve(threadCount);
+    for(size_t i = 0; i != threadCount; i++)
+        threads.emplace_back([this]() { threadMain(); });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(auto& it : threads)
+        it.join();
+}
+
+WorkStealingPool& WorkStealingPool::shared()
+{
+    static WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void WorkStealingPool::run(size_t count, const Task& task)
+{
+    if(threads.empty())
+    {
+        for(size_t i = 0; i != count; i++)
+            task(0, i);
+        return;
+    }
+
+    const size_t all = participants();
+    Loop loop {.task = &task, .ranges = std::make_unique<Range[]>(all)};
+    for(size_t i = 0; i != all; i++)
+    {
+        loop.ranges[i].begin = count * i / all;
+        loop.ranges[i].end = count * (i + 1) / all;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        loops.push_back(&loop);
+    }
+    wake.notify_all();
+
+    work(loop, 0);
+
+    std::unique_lock lock(mutex);
+    loop.drained = true;
+    std::erase(loops, &loop);
+    done.wait(lock, [&loop]() { return loop.helpers == 0; });
+}
+
+void WorkStealingPool::work(Loop& loop, size_t participant)
+{
+    size_t index;
+    while(take(loop, participant, index) || steal(loop, participant, index))
+        (*loop.task)(participant, index);
+}
+
+bool WorkStealingPool::take(Loop& loop, size_t participant, size_t& index)
+{
+    auto& own = loop.ranges[participant];
+    std::lock_guard lock(own.mutex);
+    if(own.begin == own.end)
+        return false;
+    index = own.begin++;
+    return true;
+}
+
+// the stolen half travels between the two locks, a participant which finds no work meanwhile stops early
+// and the thief runs it, so every index still runs exactly once
+bool WorkStealingPool::steal(Loop& loop, size_t participant, size_t& index)
+{
+    const size_t all = participants();
+    for(size_t i = 1; i != all; i++)
+    {
+        auto& victim = loop.ranges[(participant + i) % all];
+        size_t begin, end;
+        {
+            std::lock_guard lock(victim.mutex);
+            if(victim.begin == victim.end)
+                continue;
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        auto& own = loop.ranges[participant];
+        std::lock_guard lock(own.mutex);
+        index = begin;
+        own.begin = begin + 1;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+// loop with work left and the fewest pool threads, so concurrent callers share the pool, called with mutex held
+WorkStealingPool::Loop* WorkStealingPool::pick() const
+{
+    Loop* best = nullptr;
+    for(auto* it : loops)
+    {
+        if(!it->drained && it->joined != participants() && (!best || it->helpers < best->helpers))
+            best = it;
+    }
+    return best;
+}
+
+void WorkStealingPool::threadMain()
+{
+    std::unique_lock lock(mutex);
+    while(true)
+    {
+        Loop* loop = nullptr;
+        wake.wait(lock, [&]() { return stopping || (loop = pick()); });
+        if(stopping)
+            return;
+
+        const size_t participant = loop->joined++;
+        loop->helpers++;
+        lock.unlock();
+
+        work(*loop, participant);
+
+        lock.lock();
+        loop->drained = true;
+        if(--loop->helpers == 0)
+            done.notify_all();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads running loops over index ranges. Every participant of a loop owns a contiguous part of the range and takes indices from its front,
+// once it runs dry it steals the back half of another part, so uneven iterations balance without a shared counter.
+// The calling thread is participant 0 and works on its own loop until it finishes. Loops of concurrent callers, and loops started
+// from inside a task, run at the same time: an idle pool thread joins the running loop which has the fewest pool threads.
+class WorkStealingPool
+{
+public:
+    // participant in [0, participants()), one participant runs one index at a time; must not throw
+    using Task = std::function<void(size_t participant, size_t index)>;
+
+    explicit WorkStealingPool(size_t threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // process wide pool, one participant per hardware thread
+    static WorkStealingPool& shared();
+
+    size_t participants() const { return threads.size() + 1; }
+
+    // runs task for every index in [0, count) and returns once all finished, may be called from any thread, tasks included
+    void run(size_t count, const Task& task);
+
+protected:
+    struct alignas(64) Range
+    {
+        std::mutex mutex;
+        size_t begin {};
+        size_t end {};
+    };
+
+    // lives on the stack of run, fields besides ranges are guarded by mutex of the pool
+    struct Loop
+    {
+        const Task* task {};
+        std::unique_ptr<Range[]> ranges {};
+        size_t joined {1};      // participants given out, the caller is 0
+        size_t helpers {0};     // pool threads working on it now
+        bool drained {false};   // a participant found nothing to take or steal, indices left are held by participants already working on it
+    };
+
+    void work(Loop& loop, size_t participant);
+    bool take(Loop& loop, size_t participant, size_t& index);
+    bool steal(Loop& loop, size_t participant, size_t& index);
+    Loop* pick() const;
+    void threadMain();
+
+    std::mutex mutex;   // guards fields below
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::vector<Loop*> loops {};
+    bool stopping {false};
+
+    std::vector<std::thread> threads {};
+};
@@ -1,23 +1,131 @@
-#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <iostream>
-#include <map>
-
-#include "LexScanner.hpp"
-#include "LexToken.hpp"
+#include <iterator>
 #include <memory>
-#include <stack>
-
-#include "vx.hpp"
+#include <string>
 
-#include "AstParser.hpp"
-#include "AstTreeWalkInterpreter.hpp"
+#include "AstResolver.hpp"
 #include "CodeSource.hpp"
+#include "OutputSink.hpp"
+#include "RuntimeScope.hpp"
+#include "ScriptRunner.hpp"
+
+const std::string USAGE =
+    "usage: QLang                      interactive repl, dumps tokens, ast and bytecode of every input\n"
+    "       QLang [options] <script>   runs script file, '-' reads it from stdin, prints only program output, errors go to stderr\n"
+    "options:\n"
+    "  --vm               run on bytecode vm instead of tree walker\n"
+    "  --no-opt           skip AstOptimizer\n"
+    "  --fuel=<n>         loop iterations and calls allowed, default " + std::to_string(RuntimeBudget::DEFAULT_FUEL) + "\n"
+    "  --timeout=<ms>     wall clock limit of the execution\n"
+    "  --dump-tokens      print tokens before running\n"
+    "  --dump-ast         print ast before running\n"
+    "  --dump-bytecode    print bytecode before running, with --vm\n"
+    "  --dump             all of the dumps above\n"
+    "  --time             print duration of every stage to stderr\n"
+    "  --stats            print token, node and instruction counts and used fuel to stderr\n";
+
+// routes std::cout into sink while alive, so diagnostics stay in order with printed values
+struct CoutRedirect
+{
+    explicit CoutRedirect(OutputSink& sink) : buffer(sink), previous(std::cout.rdbuf(&buffer)) {};
+    ~CoutRedirect()
+    {
+        std::cout.flush();
+        std::cout.rdbuf(previous);
+    }
+
+    OutputSinkStreamBuf buffer;
+    std::streambuf* previous;
+};
 
+bool parseNumber(std::string_view in, uint64_t& out)
+{
+    const auto [end, error] = std::from_chars(in.data(), in.data() + in.size(), out);
+    return error == std::errc() && end == in.data() + in.size();
+}
+
+// applies one command line option, false when it is unknown or malformed
+bool parseOption(const std::string& arg, RunOptions& options)
+{
+    if(arg == "--vm")                   options.useVm = true;
+    else if(arg == "--no-opt")          options.optimize = false;
+    else if(arg == "--dump-tokens")     options.dumpTokens = true;
+    else if(arg == "--dump-ast")        options.dumpAst = true;
+    else if(arg == "--dump-bytecode")   options.dumpBytecode = true;
+    else if(arg == "--dump")            options.dumpTokens = options.dumpAst = options.dumpBytecode = true;
+    else if(arg == "--time")            options.timing = true;
+    else if(arg == "--stats")           options.stats = true;
+    else if(arg.starts_with("--fuel="))
+        return parseNumber(std::string_view(arg).substr(7), options.fuel);
+    else if(arg.starts_with("--timeout="))
+    {
+        uint64_t ms {};
+        if(!parseNumber(std::string_view(arg).substr(10), ms))
+            return false;
+        options.timeout = std::chrono::milliseconds(ms);
+    }
+    else
+        return false;
+    return true;
+}
 
-int main()
+// see USAGE, exits with 0 on success, 1 when script failed, 2 on wrong arguments
+int main(int argc, char** argv)
 {
+    FileOutputSink output(1); // stdout, std::cin is tied to std::cout so repl prompt is flushed before reading
+    CoutRedirect redirect(output);
+
     auto rootScope = RuntimeScope(nullptr);
+    auto resolver = AstResolver();
+    RunOptions options;
+
+    if(argc > 1)
+    {
+        options.errorsToStderr = true;
+        std::string path;
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if(arg == "--help")
+            {
+                std::cout << USAGE;
+                return 0;
+            }
+            if(arg.starts_with("--") ? !parseOption(arg, options) : !path.empty())
+            {
+                std::cerr << "invalid argument: " << arg << "\n" << USAGE;
+                return 2;
+            }
+            if(!arg.starts_with("--"))
+                path = arg;
+        }
+        if(path.empty())
+        {
+            std::cerr << USAGE;
+            return 2;
+        }
+
+        std::shared_ptr<CodeSource> source;
+        if(path == "-")
+            source = std::make_shared<CodeSource>("stdin", std::string(std::istreambuf_iterator<char>(std::cin), {}));
+        else
+        {
+            try
+            {
+                source = CodeSource::fromFile(path);
+            }
+            catch(std::exception& e)
+            {
+                std::cerr << "cannot read " << path << ": " << e.what() << "\n";
+                return 2;
+            }
+        }
+        return runSource(source, rootScope, resolver, output, options) ? 0 : 1;
+    }
 
+    options.dumpTokens = options.dumpAst = options.dumpBytecode = true;
     while(true)
     {
         std::shared_ptr<CodeSource> source = std::make_shared<CodeSource>("repl");
@@ -27,6 +135,20 @@ int main()
         if(source->content == "exit")
             break;
 
+        if(source->content == "backend vm" || source->content == "backend tree")
+        {
+            options.useVm = source->content == "backend vm";
+            std::cout << "backend: " << (options.useVm ? "vm" : "tree") << "\n";
+            continue;
+        }
+
+        if(source->content == "optimizer on" || source->content == "optimizer off")
+        {
+            options.optimize = source->content == "optimizer on";
+            std::cout << "optimizer: " << (options.optimize ? "on" : "off") << "\n";
+            continue;
+        }
+
         if(source->content == "multiline")
         {
             source->content = "";
@@ -41,37 +163,7 @@ int main()
             }
         }
 
-        try
-        {
-            LexScanner scanner(source,{"+","-","*","^","/","%","(",")","==","!=","<",">","<=",">=","!","&&","||","{","}",":=",",","fn"});
-
-            std::cout << "TOKEKNS: \n";
-            while ( scanner.current())
-            {
-                std::cout << scanner.current() << "\n";
-                scanner.next();
-            }
-
-            std::cout << "\nAST: \n";
-            scanner.restart();
-            auto root = AstParser(scanner).block();
-            std::cout << *root << "\n";
-
-            std::cout << "\nINTERPRET: \n";
-
-
-            treeWallInterpret(root,rootScope,rootScope,true);
-
-            std::cout << "\n";
-        }
-        catch(std::exception& e)
-        {
-            std::cout << "\nERROR OCCURED: more info above \n";
-        }
-        catch(FuncReturn& e)
-        {
-            std::cout << "\nTried return from main scope \n";
-        }
+        runSource(source, rootScope, resolver, output, options);
     }
 
     return 0;